@@ -0,0 +1,76 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <fstream>
+#include <string>
+#include <map>
+#include <utility>
+#include <sched.h>
+#include "affinity.h"
+
+// Read an integer from a sysfs file, or -1 if it is not available
+static int read_topology(int cpu, const char* name)
+{
+    std::ifstream in("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/" + name);
+    int value;
+    if(!(in >> value))
+        return -1;
+    return value;
+}
+
+std::vector<int> worker_cpus(int nworker, bool smt)
+{
+    std::vector<int> res;
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        return res;
+
+    // Group the allowed CPUs by physical core, in order of the first CPU
+    // of each core
+    std::map<std::pair<int, int>, std::size_t> core_index;
+    std::vector< std::vector<int> > cores;
+    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if(!CPU_ISSET(cpu, &allowed))
+            continue;
+        std::pair<int, int> id(read_topology(cpu, "physical_package_id"), read_topology(cpu, "core_id"));
+        // Without topology information, every CPU is its own core
+        if(id.second < 0)
+            id = std::make_pair(-1, cpu);
+        const auto it = core_index.find(id);
+        if(it == core_index.end())
+        {
+            core_index[id] = cores.size();
+            cores.push_back(std::vector<int>(1, cpu));
+        } else {
+            cores[it->second].push_back(cpu);
+        }
+    }
+
+    // One CPU per core first, then the siblings
+    for(std::size_t thread = 0; int(res.size()) < nworker; thread++)
+    {
+        bool found = false;
+        for(const std::vector<int>& core: cores)
+        {
+            if(thread < core.size() && int(res.size()) < nworker)
+            {
+                res.push_back(core[thread]);
+                found = true;
+            }
+        }
+        if(!found || !smt)
+            break;
+    }
+    return res;
+}
+
+bool pin_thread(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    // 0 is the calling thread on Linux
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
@@ -0,0 +1,24 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_AFFINITY_H
+#define CUTEST_AFFINITY_H
+
+#include <vector>
+
+// Logical CPUs to pin the workers to, at most nworker of them
+//
+// Only the CPUs the process is allowed to run on are used. Each physical
+// core (core_id and physical_package_id in /sys/devices/system/cpu) gets at
+// most one worker, so that parallel solves do not share a core. If smt is
+// true and there are more workers than cores, the remaining workers use the
+// SMT siblings; otherwise the siblings are left idle and fewer CPUs than
+// nworker are returned
+std::vector<int> worker_cpus(int nworker, bool smt);
+
+// Pin the calling thread, and the processes it starts later, to a logical
+// CPU. Returns false on failure
+bool pin_thread(int cpu);
+
+
+#endif  // CUTEST_AFFINITY_H
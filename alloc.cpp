@@ -0,0 +1,98 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <cstddef>
+#include <cerrno>
+#include "alloc.h"
+
+#ifdef CUTEST_ALLOC_COUNT
+
+// Allocator of glibc, which the hooks forward to
+extern "C" {
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t n, std::size_t size);
+void* __libc_realloc(void* ptr, std::size_t size);
+void* __libc_memalign(std::size_t alignment, std::size_t size);
+}
+
+// Plain thread-local integers, which need no allocation to be set up
+static thread_local bool alloc_enabled = false;
+static thread_local long alloc_count = 0;
+static thread_local long alloc_bytes = 0;
+
+static inline void count_alloc(std::size_t size)
+{
+    if(alloc_enabled)
+    {
+        alloc_count++;
+        alloc_bytes += long(size);
+    }
+}
+
+extern "C" {
+
+void* malloc(std::size_t size)
+{
+    count_alloc(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(std::size_t n, std::size_t size)
+{
+    count_alloc(n * size);
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, std::size_t size)
+{
+    count_alloc(size);
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(std::size_t alignment, std::size_t size)
+{
+    count_alloc(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(std::size_t alignment, std::size_t size)
+{
+    count_alloc(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, std::size_t alignment, std::size_t size)
+{
+    count_alloc(size);
+    void* res = __libc_memalign(alignment, size);
+    if(!res)
+        return ENOMEM;
+    *ptr = res;
+    return 0;
+}
+
+}
+
+bool alloc_count_available() { return true; }
+
+bool alloc_count_enable(bool enable)
+{
+    const bool prev = alloc_enabled;
+    alloc_enabled = enable;
+    return prev;
+}
+
+AllocCounts alloc_count_read()
+{
+    return AllocCounts(alloc_count, alloc_bytes);
+}
+
+#else
+
+bool alloc_count_available() { return false; }
+
+bool alloc_count_enable(bool) { return false; }
+
+AllocCounts alloc_count_read() { return AllocCounts(); }
+
+#endif  // CUTEST_ALLOC_COUNT
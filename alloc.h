@@ -0,0 +1,42 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_ALLOC_H
+#define CUTEST_ALLOC_H
+
+// Number and size of heap allocations
+struct AllocCounts
+{
+    long count;
+    long bytes;
+
+    AllocCounts() : count(0), bytes(0) {}
+    AllocCounts(long count_, long bytes_) : count(count_), bytes(bytes_) {}
+
+    AllocCounts operator-(const AllocCounts& other) const
+    {
+        return AllocCounts(count - other.count, bytes - other.bytes);
+    }
+};
+
+// Counting of heap allocations, in the build mode enabled by
+// `make ALLOC_COUNT=1` (which defines CUTEST_ALLOC_COUNT)
+//
+// In this mode malloc(), calloc(), realloc() and the aligned variants are
+// replaced by hooks that forward to glibc and count the allocations of the
+// calling thread while counting is enabled. operator new and Eigen both
+// allocate through malloc(), so they are covered as well. In the default
+// build the functions below do nothing and nothing is counted
+
+// Whether the program was built with the counting hooks
+bool alloc_count_available();
+
+// Enable or disable counting in the calling thread, and return the
+// previous state
+bool alloc_count_enable(bool enable);
+
+// Allocations counted in the calling thread so far
+AllocCounts alloc_count_read();
+
+
+#endif  // CUTEST_ALLOC_H
@@ -0,0 +1,270 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <cmath>
+#include <limits>
+#include <map>
+#include <set>
+#include <algorithm>
+#include "analysis.h"
+#include "results.h"
+
+using json = nlohmann::json;
+
+static const double inf = std::numeric_limits<double>::infinity();
+
+const char* metric_name(int metric)
+{
+    static const char* names[] = { "time", "nfun", "niter" };
+    return (metric >= 0 && metric < nmetric) ? names[metric] : "";
+}
+
+// Classic and LBFGS++ first, then by name
+static int solver_rank(const std::string& solver)
+{
+    if(solver == "Classic")
+        return 0;
+    if(solver == "LBFGS++")
+        return 1;
+    return 2;
+}
+
+// Field of a record selected for the comparison
+struct RecordEntry
+{
+    std::string solver;
+    int         nvar;
+    int         flag;
+    double      objval;
+    double      cost[nmetric];
+};
+
+std::vector<ResultTable> build_tables(const std::vector<json>& records, const AnalysisOptions& opts)
+{
+    // Solvers are only labelled by their config if there are several
+    std::set<std::string> configs;
+    for(const json& rec: records)
+        configs.insert(rec.contains("config") ? rec["config"].dump() : "{}");
+    const bool by_config = configs.size() > 1;
+
+    // Algorithm -> problem -> label -> entry
+    std::map<std::string, std::map<std::string, std::map<std::string, RecordEntry>>> entries;
+    for(const json& rec: records)
+    {
+        const std::string prob = rec.value("problem", std::string());
+        const std::string alg = rec.value("alg", std::string());
+        if(prob.empty() || alg.empty())
+            continue;
+        RecordEntry entry;
+        entry.solver = rec.value("solver", std::string());
+        std::string label = entry.solver;
+        if(by_config)
+            label += " " + (rec.contains("config") ? rec["config"].dump() : std::string("{}"));
+        entry.nvar = int(record_number(rec.value("nvar", json())));
+        entry.flag = rec.value("flag", json()).is_number_integer() ? rec["flag"].get<int>() : 1;
+        entry.objval = record_number(rec.value("objval", json()));
+
+        double time = record_number(rec.value("solve_time", json()));
+        const auto timing = rec.find("timing");
+        if(timing != rec.end() && timing->is_object() && timing->contains("median"))
+            time = record_number((*timing)["median"]);
+        entry.cost[metric_time] = std::max(time, opts.min_time);
+        entry.cost[metric_nfun] = record_number(rec.value("nfun", json()));
+        entry.cost[metric_niter] = record_number(rec.value("niter", json()));
+        entries[alg][prob][label] = entry;
+    }
+
+    std::vector<ResultTable> tables;
+    for(const auto& alg: entries)
+    {
+        ResultTable table;
+        table.alg = alg.first;
+        table.nincomplete = 0;
+
+        std::map<std::string, int> ranks;
+        for(const auto& prob: alg.second)
+            for(const auto& s: prob.second)
+                ranks[s.first] = solver_rank(s.second.solver);
+        for(const auto& r: ranks)
+            table.solvers.push_back(r.first);
+        std::stable_sort(table.solvers.begin(), table.solvers.end(),
+            [&ranks](const std::string& a, const std::string& b) { return ranks[a] < ranks[b]; });
+
+        for(const auto& prob: alg.second)
+        {
+            if(prob.second.size() < table.solvers.size())
+            {
+                table.nincomplete++;
+                continue;
+            }
+            std::vector<ProblemResult> row;
+            double best = inf;
+            for(const std::string& solver: table.solvers)
+            {
+                const RecordEntry& entry = prob.second.at(solver);
+                ProblemResult res;
+                res.flag = entry.flag;
+                res.objval = entry.objval;
+                res.solved = (entry.flag == 0) && std::isfinite(entry.objval);
+                for(int m = 0; m < nmetric; m++)
+                {
+                    res.cost[m] = entry.cost[m];
+                    res.solved = res.solved && std::isfinite(entry.cost[m]);
+                }
+                if(res.solved)
+                    best = std::min(best, res.objval);
+                row.push_back(res);
+            }
+            for(ProblemResult& res: row)
+            {
+                if(res.solved && opts.ftol > 0.0 &&
+                   res.objval > best + opts.ftol * std::max(1.0, std::abs(best)))
+                    res.solved = false;
+                if(!res.solved)
+                    std::fill(res.cost, res.cost + nmetric, inf);
+            }
+            table.problems.push_back(prob.first);
+            table.nvar.push_back(prob.second.begin()->second.nvar);
+            table.results.push_back(row);
+        }
+        tables.push_back(table);
+    }
+    return tables;
+}
+
+PerformanceProfile performance_profile(const ResultTable& table, int metric, const AnalysisOptions&)
+{
+    const std::size_t nprob = table.problems.size(), nsolver = table.solvers.size();
+    PerformanceProfile prof;
+    prof.rho.resize(nsolver);
+    if(nprob == 0)
+        return prof;
+
+    // Ratios of each solver, sorted
+    std::vector<std::vector<double>> ratios(nsolver);
+    for(std::size_t p = 0; p < nprob; p++)
+    {
+        const std::vector<ProblemResult>& row = table.results[p];
+        double best = inf;
+        for(const ProblemResult& res: row)
+            best = std::min(best, res.cost[metric]);
+        for(std::size_t s = 0; s < nsolver; s++)
+        {
+            double r = inf;
+            if(std::isfinite(best) && std::isfinite(row[s].cost[metric]))
+                r = (best > 0.0) ? row[s].cost[metric] / best : 1.0;
+            ratios[s].push_back(r);
+            if(std::isfinite(r))
+                prof.tau.push_back(r);
+        }
+    }
+    prof.tau.push_back(1.0);
+    std::sort(prof.tau.begin(), prof.tau.end());
+    prof.tau.erase(std::unique(prof.tau.begin(), prof.tau.end()), prof.tau.end());
+
+    for(std::size_t s = 0; s < nsolver; s++)
+    {
+        std::sort(ratios[s].begin(), ratios[s].end());
+        std::size_t count = 0;
+        for(double tau: prof.tau)
+        {
+            while(count < nprob && ratios[s][count] <= tau)
+                count++;
+            prof.rho[s].push_back(double(count) / nprob);
+        }
+    }
+    return prof;
+}
+
+int size_bucket(int nvar)
+{
+    int bucket = 0;
+    for(long n = 10; bucket < nsize_bucket - 1 && nvar >= n; n *= 10)
+        bucket++;
+    return bucket;
+}
+
+std::string size_bucket_name(int bucket)
+{
+    if(bucket < 0)
+        return "all";
+    long lower = 1;
+    for(int i = 0; i < bucket; i++)
+        lower *= 10;
+    if(bucket == nsize_bucket - 1)
+        return ">=" + std::to_string(lower);
+    return std::to_string(lower) + "-" + std::to_string(lower * 10 - 1);
+}
+
+double shifted_geomean(const std::vector<double>& x, double shift)
+{
+    if(x.empty())
+        return std::numeric_limits<double>::quiet_NaN();
+    double sum = 0.0;
+    for(double xi: x)
+        sum += std::log(xi + shift);
+    return std::exp(sum / x.size()) - shift;
+}
+
+json summarize(const ResultTable& table, int bucket, const AnalysisOptions& opts)
+{
+    const std::size_t nsolver = table.solvers.size();
+    std::vector<std::size_t> probs, solved;
+    for(std::size_t p = 0; p < table.problems.size(); p++)
+    {
+        if(bucket >= 0 && size_bucket(table.nvar[p]) != bucket)
+            continue;
+        probs.push_back(p);
+        bool all = true;
+        for(const ProblemResult& res: table.results[p])
+            all = all && res.solved;
+        if(all)
+            solved.push_back(p);
+    }
+
+    // Geometric means on the problems solved by every solver
+    std::vector<std::vector<double>> sgm(nsolver, std::vector<double>(nmetric));
+    for(std::size_t s = 0; s < nsolver; s++)
+    {
+        for(int m = 0; m < nmetric; m++)
+        {
+            std::vector<double> x;
+            for(std::size_t p: solved)
+                x.push_back(table.results[p][s].cost[m]);
+            sgm[s][m] = shifted_geomean(x, opts.shift[m]);
+        }
+    }
+
+    json solvers = json::array();
+    for(std::size_t s = 0; s < nsolver; s++)
+    {
+        int nfail = 0;
+        std::map<std::string, int> flags;
+        for(std::size_t p: probs)
+        {
+            const ProblemResult& res = table.results[p][s];
+            if(!res.solved)
+                nfail++;
+            if(res.flag != 0)
+                flags[std::to_string(res.flag)]++;
+        }
+        json entry = {
+            {"solver", table.solvers[s]},
+            {"failures", nfail},
+            {"flags", flags}
+        };
+        for(int m = 0; m < nmetric; m++)
+        {
+            entry[std::string("sgm_") + metric_name(m)] = sgm[s][m];
+            entry[std::string("speedup_") + metric_name(m)] = sgm[0][m] / sgm[s][m];
+        }
+        solvers.push_back(entry);
+    }
+
+    return json{
+        {"bucket", size_bucket_name(bucket)},
+        {"problems", probs.size()},
+        {"solved", solved.size()},
+        {"solvers", solvers}
+    };
+}
@@ -0,0 +1,106 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_ANALYSIS_H
+#define CUTEST_ANALYSIS_H
+
+#include <string>
+#include <vector>
+#include "json.hpp"
+
+// Comparison of solvers on the records of result logs
+//
+// The solvers compared are the (solver, config) pairs of the records,
+// labelled by the solver name, followed by the config if the logs have
+// several. Problems are compared within each algorithm (L-BFGS or
+// L-BFGS-B), on the problems that every solver of the algorithm was run
+// on; when a (problem, solver) pair appears twice, the last record is used
+
+// Costs compared between the solvers
+enum Metric
+{
+    metric_time = 0,   // timing.median if the solve was repeated, otherwise solve_time
+    metric_nfun,
+    metric_niter,
+    nmetric
+};
+
+const char* metric_name(int metric);
+
+// Result of one solver on one problem
+struct ProblemResult
+{
+    int         flag;
+    bool        solved;         // See AnalysisOptions::ftol
+    double      objval;
+    double      cost[nmetric];  // Infinity if not solved
+};
+
+struct AnalysisOptions
+{
+    // A solve with flag 0 still fails if its objective value exceeds the
+    // best one of the problem by more than ftol * max(1, |best|); 0 to only
+    // use the flag
+    double ftol;
+    // Shift of the geometric means, per metric
+    double shift[nmetric];
+    // Times are at least min_time seconds, so that ratios of solves below
+    // the timer resolution stay finite
+    double min_time;
+
+    AnalysisOptions() : ftol(0.0), min_time(1e-6)
+    {
+        shift[metric_time] = 1e-3;
+        shift[metric_nfun] = 10.0;
+        shift[metric_niter] = 10.0;
+    }
+};
+
+// Results of the solvers of one algorithm
+struct ResultTable
+{
+    std::string alg;
+    std::vector<std::string> solvers;        // Classic and LBFGS++ first
+    std::vector<std::string> problems;       // Sorted by name
+    std::vector<int> nvar;                   // Per problem
+    std::vector<std::vector<ProblemResult>> results;  // [problem][solver]
+    int nincomplete;                         // Problems missing for some solver, left out
+};
+
+// Group the records by algorithm
+std::vector<ResultTable> build_tables(const std::vector<nlohmann::json>& records,
+                                      const AnalysisOptions& opts);
+
+// Dolan-More performance profile of a table on a metric: rho[s][i] is the
+// fraction of the problems on which the cost of solver s is within a
+// factor tau[i] of the best solver. tau holds the distinct finite ratios
+// in increasing order, starting at 1
+struct PerformanceProfile
+{
+    std::vector<double> tau;
+    std::vector<std::vector<double>> rho;
+};
+
+PerformanceProfile performance_profile(const ResultTable& table, int metric, const AnalysisOptions& opts);
+
+// Size class of a problem: the decade of nvar, the last one open-ended
+int size_bucket(int nvar);
+std::string size_bucket_name(int bucket);
+const int nsize_bucket = 5;
+
+// Summary of a table over the problems of a size bucket, or all problems
+// if bucket < 0:
+//   problems   Number of problems
+//   solved     Number of problems solved by every solver, on which the
+//              geometric means are computed
+//   solvers    Per solver: "solver", "failures", "flags" (count per nonzero
+//              flag), and per metric the shifted geometric mean "sgm_<metric>"
+//              and "speedup_<metric>", the ratio of the mean of the first
+//              solver to the mean of this one (> 1 is faster)
+nlohmann::json summarize(const ResultTable& table, int bucket, const AnalysisOptions& opts);
+
+// exp(mean(log(x + shift))) - shift, NaN for an empty vector
+double shifted_geomean(const std::vector<double>& x, double shift);
+
+
+#endif  // CUTEST_ANALYSIS_H
@@ -0,0 +1,549 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <map>
+#include <algorithm>
+#include <sys/stat.h>
+#include "analysis.h"
+#include "results.h"
+#include "trace.h"
+
+using json = nlohmann::json;
+
+// Summarize result logs: failures, shifted geometric means and speedups
+// per size of the problems, and performance profiles (see analysis.h)
+//
+// A text summary is printed to stdout. With -o DIR, the following files are
+// also written to DIR:
+//   summary.json   Summaries of every algorithm and size bucket
+//   buckets.csv    The same as a table, one row per solver
+//   profiles.csv   Performance profiles: alg, metric, solver, tau, rho
+//   problems.csv   Result of every solver on every problem compared
+//   report.html    Self-contained report with the summaries, plots of the
+//                  profiles and of the traces given with --trace, and the
+//                  table of problems
+
+void print_usage()
+{
+    std::cerr << "Usage: analyze_results.out [--ftol TOL] [--shift-time S] [--trace FILE]... [-o DIR] LOG..." << std::endl;
+    std::cerr << "  --ftol       A solve also fails if its objective value exceeds the best one by" << std::endl;
+    std::cerr << "               more than TOL * max(1, |best|) (default: 0, only the flag counts)" << std::endl;
+    std::cerr << "  --shift-time Shift of the geometric means of the times in seconds (default: 0.001)" << std::endl;
+    std::cerr << "  --trace      Trace of a solve (the \"trace\" parameter), plotted in the report;" << std::endl;
+    std::cerr << "               can be repeated" << std::endl;
+    std::cerr << "  -o DIR       Write CSV, JSON and HTML output to DIR" << std::endl;
+}
+
+// Number as printed in the tables and CSV files
+static std::string format_number(double x, const char* fmt = "%.6g")
+{
+    if(std::isnan(x))
+        return "NA";
+    if(std::isinf(x))
+        return (x > 0) ? "Inf" : "-Inf";
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), fmt, x);
+    return buf;
+}
+
+static std::string csv_field(const std::string& str)
+{
+    if(str.find_first_of(",\"\n") == std::string::npos)
+        return str;
+    std::string out = "\"";
+    for(char c: str)
+        out += (c == '"') ? std::string("\"\"") : std::string(1, c);
+    return out + "\"";
+}
+
+static std::string html_escape(const std::string& str)
+{
+    std::string out;
+    for(char c: str)
+    {
+        switch(c)
+        {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"': out += "&quot;"; break;
+            default:  out += c;
+        }
+    }
+    return out;
+}
+
+// Text summary of a table
+static void print_summary(const ResultTable& table, const std::vector<json>& summaries)
+{
+    std::cout << table.alg << ": " << table.problems.size() << " problems";
+    if(table.nincomplete > 0)
+        std::cout << " (" << table.nincomplete << " left out, not run by every solver)";
+    std::cout << std::endl;
+    std::printf("  %-12s %8s %8s  %-20s %8s %12s %8s %12s %8s %12s %8s\n",
+                "nvar", "problems", "solved", "solver", "failures",
+                "sgm time", "speedup", "sgm nfun", "speedup", "sgm niter", "speedup");
+    for(const json& sum: summaries)
+    {
+        if(sum["problems"].get<int>() == 0)
+            continue;
+        bool first = true;
+        for(const json& s: sum["solvers"])
+        {
+            std::printf("  %-12s %8s %8s  %-20s %8d",
+                        first ? sum["bucket"].get<std::string>().c_str() : "",
+                        first ? std::to_string(sum["problems"].get<int>()).c_str() : "",
+                        first ? std::to_string(sum["solved"].get<int>()).c_str() : "",
+                        s["solver"].get<std::string>().substr(0, 20).c_str(),
+                        s["failures"].get<int>());
+            for(int m = 0; m < nmetric; m++)
+            {
+                std::printf(" %12s %8s",
+                            format_number(record_number(s[std::string("sgm_") + metric_name(m)])).c_str(),
+                            format_number(record_number(s[std::string("speedup_") + metric_name(m)]), "%.3f").c_str());
+            }
+            std::printf("\n");
+            first = false;
+        }
+    }
+    std::fflush(stdout);
+}
+
+// Iterations of a trace file
+struct TraceData
+{
+    std::string alg, prob, solver;
+    std::vector<TraceEntry> iters;
+};
+
+static bool read_trace(const std::string& path, TraceData& trace)
+{
+    std::ifstream in(path, std::ios::binary);
+    TraceHeader header;
+    if(!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+       std::memcmp(header.magic, "CUTTRACE", 8) != 0 || header.version != 1 ||
+       header.entry_size != sizeof(TraceEntry))
+        return false;
+    header.prob[15] = header.alg[15] = header.solver[15] = '\0';
+    trace.alg = header.alg;
+    trace.prob = header.prob;
+    trace.solver = header.solver;
+    TraceEntry e;
+    while(in.read(reinterpret_cast<char*>(&e), sizeof(e)))
+    {
+        if(e.kind == 2)
+            trace.iters.push_back(e);
+    }
+    return true;
+}
+
+////////////////////////////// SVG plots //////////////////////////////
+
+static const char* plot_colors[] = {
+    "#1f77b4", "#d62728", "#2ca02c", "#ff7f0e", "#9467bd", "#8c564b", "#e377c2", "#7f7f7f"
+};
+static const int nplot_color = sizeof(plot_colors) / sizeof(plot_colors[0]);
+
+// Scale of an axis: the data are given as log2 or log10 of the values,
+// and the ticks are labelled with the values
+enum AxisScale { axis_linear, axis_log2, axis_log10 };
+
+struct Series
+{
+    std::string name;
+    std::vector<double> x, y;
+};
+
+static std::string tick_label(double v, AxisScale scale)
+{
+    if(scale == axis_log2)
+        return format_number(std::pow(2.0, v), "%g");
+    if(scale == axis_log10)
+        return "1e" + format_number(v, "%g");
+    return format_number(v, "%g");
+}
+
+// Ticks at round positions covering [lo, hi]
+static std::vector<double> axis_ticks(double lo, double hi, AxisScale scale)
+{
+    double step;
+    if(scale == axis_linear)
+    {
+        const double raw = (hi - lo) / 4.0;
+        const double mag = std::pow(10.0, std::floor(std::log10(raw)));
+        step = mag * ((raw / mag >= 5) ? 5 : (raw / mag >= 2) ? 2 : 1);
+    } else {
+        step = std::max(1.0, std::ceil((hi - lo) / 6.0));
+    }
+    std::vector<double> ticks;
+    for(double t = std::ceil(lo / step) * step; t <= hi + 1e-9 * step; t += step)
+        ticks.push_back(t);
+    return ticks;
+}
+
+static std::string svg_plot(const std::string& title, const std::string& xlabel, const std::string& ylabel,
+                            const std::vector<Series>& series, AxisScale xscale, AxisScale yscale,
+                            double xmin, double xmax, double ymin, double ymax)
+{
+    const double width = 400, height = 280;
+    const double left = 60, right = 15, top = 28, bottom = 45;
+    const double pw = width - left - right, ph = height - top - bottom;
+    if(!(xmax > xmin))
+        xmax = xmin + 1.0;
+    if(!(ymax > ymin))
+        ymax = ymin + 1.0;
+    auto px = [&](double x) { return left + (x - xmin) / (xmax - xmin) * pw; };
+    auto py = [&](double y) { return top + (ymax - y) / (ymax - ymin) * ph; };
+
+    std::ostringstream svg;
+    svg << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << width << "\" height=\"" << height
+        << "\" font-family=\"sans-serif\" font-size=\"11\">\n";
+    svg << "<text x=\"" << width / 2 << "\" y=\"16\" text-anchor=\"middle\" font-size=\"13\">"
+        << html_escape(title) << "</text>\n";
+    svg << "<rect x=\"" << left << "\" y=\"" << top << "\" width=\"" << pw << "\" height=\"" << ph
+        << "\" fill=\"none\" stroke=\"#444\"/>\n";
+    for(double t: axis_ticks(xmin, xmax, xscale))
+    {
+        svg << "<line x1=\"" << px(t) << "\" x2=\"" << px(t) << "\" y1=\"" << top << "\" y2=\"" << top + ph
+            << "\" stroke=\"#ddd\"/><text x=\"" << px(t) << "\" y=\"" << top + ph + 14
+            << "\" text-anchor=\"middle\">" << tick_label(t, xscale) << "</text>\n";
+    }
+    for(double t: axis_ticks(ymin, ymax, yscale))
+    {
+        svg << "<line x1=\"" << left << "\" x2=\"" << left + pw << "\" y1=\"" << py(t) << "\" y2=\"" << py(t)
+            << "\" stroke=\"#ddd\"/><text x=\"" << left - 4 << "\" y=\"" << py(t) + 4
+            << "\" text-anchor=\"end\">" << tick_label(t, yscale) << "</text>\n";
+    }
+    svg << "<text x=\"" << left + pw / 2 << "\" y=\"" << height - 8 << "\" text-anchor=\"middle\">"
+        << html_escape(xlabel) << "</text>\n";
+    svg << "<text transform=\"translate(14," << top + ph / 2 << ") rotate(-90)\" text-anchor=\"middle\">"
+        << html_escape(ylabel) << "</text>\n";
+
+    for(std::size_t i = 0; i < series.size(); i++)
+    {
+        const Series& s = series[i];
+        const char* color = plot_colors[i % nplot_color];
+        svg << "<polyline fill=\"none\" stroke=\"" << color << "\" stroke-width=\"1.5\" points=\"";
+        for(std::size_t j = 0; j < s.x.size(); j++)
+            svg << format_number(px(s.x[j]), "%.1f") << "," << format_number(py(s.y[j]), "%.1f") << " ";
+        svg << "\"/>\n";
+        const double ly = top + ph - 10 - 14 * (series.size() - 1 - i);
+        svg << "<line x1=\"" << left + pw - 120 << "\" x2=\"" << left + pw - 100 << "\" y1=\"" << ly - 4
+            << "\" y2=\"" << ly - 4 << "\" stroke=\"" << color << "\" stroke-width=\"2\"/>"
+            << "<text x=\"" << left + pw - 95 << "\" y=\"" << ly << "\">" << html_escape(s.name) << "</text>\n";
+    }
+    svg << "</svg>\n";
+    return svg.str();
+}
+
+// Performance profile as step functions of log2(tau)
+static std::string profile_plot(const ResultTable& table, int metric, const PerformanceProfile& prof)
+{
+    const double xmax = prof.tau.empty() ? 1.0 : std::max(1.0, 1.05 * std::log2(prof.tau.back()));
+    std::vector<Series> series;
+    for(std::size_t s = 0; s < table.solvers.size(); s++)
+    {
+        Series line;
+        line.name = table.solvers[s];
+        for(std::size_t i = 0; i < prof.tau.size(); i++)
+        {
+            const double x = std::log2(prof.tau[i]);
+            if(i > 0)
+            {
+                line.x.push_back(x);
+                line.y.push_back(prof.rho[s][i - 1]);
+            }
+            line.x.push_back(x);
+            line.y.push_back(prof.rho[s][i]);
+        }
+        line.x.push_back(xmax);
+        line.y.push_back(prof.rho[s].empty() ? 0.0 : prof.rho[s].back());
+        series.push_back(line);
+    }
+    return svg_plot(std::string(metric_name(metric)), "ratio to the best solver (tau)",
+                    "fraction of problems", series, axis_log2, axis_linear, 0.0, xmax, 0.0, 1.0);
+}
+
+// Convergence of the traces of a problem: projected gradient and gap to the
+// best objective value of the traces, per iteration
+static std::string convergence_plots(const std::vector<const TraceData*>& traces)
+{
+    double fbest = INFINITY;
+    for(const TraceData* t: traces)
+        for(const TraceEntry& e: t->iters)
+            fbest = std::min(fbest, e.f);
+    const double floor = 1e-16 * std::max(1.0, std::abs(fbest));
+
+    std::vector<Series> grad, gap;
+    double xmax = 1.0, gmin = INFINITY, gmax = -INFINITY, fmin = INFINITY, fmax = -INFINITY;
+    for(const TraceData* t: traces)
+    {
+        Series g, f;
+        g.name = f.name = t->solver;
+        for(const TraceEntry& e: t->iters)
+        {
+            xmax = std::max(xmax, double(e.index));
+            if(e.gnorm > 0.0 && std::isfinite(e.gnorm))
+            {
+                g.x.push_back(e.index);
+                g.y.push_back(std::log10(e.gnorm));
+                gmin = std::min(gmin, g.y.back());
+                gmax = std::max(gmax, g.y.back());
+            }
+            if(std::isfinite(e.f))
+            {
+                f.x.push_back(e.index);
+                f.y.push_back(std::log10(std::max(e.f - fbest, floor)));
+                fmin = std::min(fmin, f.y.back());
+                fmax = std::max(fmax, f.y.back());
+            }
+        }
+        grad.push_back(g);
+        gap.push_back(f);
+    }
+    if(!std::isfinite(gmin))
+        gmin = gmax = 0.0;
+    if(!std::isfinite(fmin))
+        fmin = fmax = 0.0;
+    return svg_plot("gradient norm", "iteration", "", grad, axis_linear, axis_log10,
+                    0.0, xmax, std::floor(gmin), std::ceil(gmax)) +
+           svg_plot("f - best f", "iteration", "", gap, axis_linear, axis_log10,
+                    0.0, xmax, std::floor(fmin), std::ceil(fmax));
+}
+
+////////////////////////////// Output files //////////////////////////////
+
+static const char* report_style =
+    "body { font-family: sans-serif; margin: 2em; color: #222; }\n"
+    "table { border-collapse: collapse; margin: 1em 0; font-size: 13px; }\n"
+    "th, td { border: 1px solid #ccc; padding: 3px 8px; text-align: right; }\n"
+    "th { background: #f0f0f0; }\n"
+    "td.name { text-align: left; }\n"
+    "td.fail { color: #c00; }\n"
+    "svg { margin: 0 1em 1em 0; }\n";
+
+static bool write_outputs(const std::string& dir, const std::vector<ResultTable>& tables,
+                          const std::vector<std::vector<json>>& summaries,
+                          const std::vector<std::vector<PerformanceProfile>>& profiles,
+                          const std::vector<TraceData>& traces)
+{
+    if(mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+        std::cerr << dir << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    std::ofstream summary_json(dir + "/summary.json");
+    std::ofstream buckets_csv(dir + "/buckets.csv");
+    std::ofstream profiles_csv(dir + "/profiles.csv");
+    std::ofstream problems_csv(dir + "/problems.csv");
+    std::ofstream html(dir + "/report.html");
+
+    json all = json::array();
+    buckets_csv << "alg,bucket,problems,solved,solver,failures";
+    for(int m = 0; m < nmetric; m++)
+        buckets_csv << ",sgm_" << metric_name(m) << ",speedup_" << metric_name(m);
+    buckets_csv << "\n";
+    profiles_csv << "alg,metric,solver,tau,rho\n";
+    problems_csv << "alg,problem,nvar,solver,flag,solved,objval,time,nfun,niter\n";
+
+    html << "<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\">\n<title>Benchmark report</title>\n<style>\n"
+         << report_style << "</style></head><body>\n<h1>Benchmark report</h1>\n";
+    html << "<p>Failures are solves with a nonzero flag or a worse objective value than the best by more than "
+            "the tolerance. Shifted geometric means are computed on the problems solved by every solver, "
+            "and the speedup is the mean of the first solver divided by the mean of each solver.</p>\n";
+
+    for(std::size_t t = 0; t < tables.size(); t++)
+    {
+        const ResultTable& table = tables[t];
+        all.push_back(json{
+            {"alg", table.alg},
+            {"problems", table.problems.size()},
+            {"left_out", table.nincomplete},
+            {"solvers", table.solvers},
+            {"buckets", summaries[t]}
+        });
+
+        html << "<h2>" << html_escape(table.alg) << "</h2>\n<p>" << table.problems.size() << " problems";
+        if(table.nincomplete > 0)
+            html << ", " << table.nincomplete << " left out as they were not run by every solver";
+        html << ".</p>\n<table><tr><th>nvar</th><th>problems</th><th>solved by all</th><th>solver</th><th>failures</th>";
+        for(int m = 0; m < nmetric; m++)
+            html << "<th>sgm " << metric_name(m) << "</th><th>speedup</th>";
+        html << "</tr>\n";
+        for(const json& sum: summaries[t])
+        {
+            if(sum["problems"].get<int>() == 0)
+                continue;
+            const std::size_t nsolver = sum["solvers"].size();
+            bool first = true;
+            for(const json& s: sum["solvers"])
+            {
+                buckets_csv << csv_field(table.alg) << "," << csv_field(sum["bucket"].get<std::string>()) << ","
+                            << sum["problems"] << "," << sum["solved"] << "," << csv_field(s["solver"].get<std::string>())
+                            << "," << s["failures"];
+                html << "<tr>";
+                if(first)
+                {
+                    html << "<td class=\"name\" rowspan=\"" << nsolver << "\">" << html_escape(sum["bucket"].get<std::string>())
+                         << "</td><td rowspan=\"" << nsolver << "\">" << sum["problems"]
+                         << "</td><td rowspan=\"" << nsolver << "\">" << sum["solved"] << "</td>";
+                }
+                html << "<td class=\"name\">" << html_escape(s["solver"].get<std::string>()) << "</td><td>"
+                     << s["failures"] << "</td>";
+                for(int m = 0; m < nmetric; m++)
+                {
+                    const std::string sgm = format_number(record_number(s[std::string("sgm_") + metric_name(m)]));
+                    const std::string speedup = format_number(record_number(s[std::string("speedup_") + metric_name(m)]), "%.3f");
+                    buckets_csv << "," << sgm << "," << speedup;
+                    html << "<td>" << sgm << "</td><td>" << speedup << "</td>";
+                }
+                buckets_csv << "\n";
+                html << "</tr>\n";
+                first = false;
+            }
+        }
+        html << "</table>\n<h3>Performance profiles</h3>\n<div>\n";
+
+        for(int m = 0; m < nmetric; m++)
+        {
+            const PerformanceProfile& prof = profiles[t][m];
+            for(std::size_t s = 0; s < table.solvers.size(); s++)
+                for(std::size_t i = 0; i < prof.tau.size(); i++)
+                    profiles_csv << csv_field(table.alg) << "," << metric_name(m) << "," << csv_field(table.solvers[s])
+                                 << "," << format_number(prof.tau[i], "%.10g") << "," << format_number(prof.rho[s][i], "%.10g") << "\n";
+            html << profile_plot(table, m, prof);
+        }
+        html << "</div>\n";
+
+        // Convergence of the traces of this algorithm, by problem
+        std::map<std::string, std::vector<const TraceData*>> by_prob;
+        for(const TraceData& trace: traces)
+            if(trace.alg == table.alg)
+                by_prob[trace.prob].push_back(&trace);
+        if(!by_prob.empty())
+        {
+            html << "<h3>Convergence</h3>\n";
+            for(const auto& prob: by_prob)
+                html << "<h4>" << html_escape(prob.first) << "</h4>\n<div>\n" << convergence_plots(prob.second) << "</div>\n";
+        }
+
+        html << "<details><summary>Problems</summary>\n<table><tr><th>problem</th><th>nvar</th>";
+        for(const std::string& solver: table.solvers)
+            html << "<th>" << html_escape(solver) << " flag</th><th>objval</th><th>time</th><th>nfun</th><th>niter</th>";
+        html << "</tr>\n";
+        for(std::size_t p = 0; p < table.problems.size(); p++)
+        {
+            html << "<tr><td class=\"name\">" << html_escape(table.problems[p]) << "</td><td>" << table.nvar[p] << "</td>";
+            for(std::size_t s = 0; s < table.solvers.size(); s++)
+            {
+                const ProblemResult& res = table.results[p][s];
+                problems_csv << csv_field(table.alg) << "," << csv_field(table.problems[p]) << "," << table.nvar[p] << ","
+                             << csv_field(table.solvers[s]) << "," << res.flag << "," << (res.solved ? 1 : 0) << ","
+                             << format_number(res.objval, "%.10g");
+                html << "<td" << (res.solved ? "" : " class=\"fail\"") << ">" << res.flag << "</td><td>"
+                     << format_number(res.objval) << "</td>";
+                for(int m = 0; m < nmetric; m++)
+                {
+                    problems_csv << "," << format_number(res.cost[m], "%.10g");
+                    html << "<td>" << format_number(res.cost[m]) << "</td>";
+                }
+                problems_csv << "\n";
+            }
+            html << "</tr>\n";
+        }
+        html << "</table></details>\n";
+    }
+    html << "</body></html>\n";
+    summary_json << record_line(all) << std::endl;
+
+    if(!summary_json || !buckets_csv || !profiles_csv || !problems_csv || !html)
+    {
+        std::cerr << dir << ": cannot write the output files" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    AnalysisOptions opts;
+    std::string out_dir;
+    std::vector<std::string> logs, trace_files;
+    for(int i = 1; i < argc; i++)
+    {
+        if(std::strcmp(argv[i], "--ftol") == 0 && i + 1 < argc)
+        {
+            opts.ftol = std::atof(argv[++i]);
+        } else if(std::strcmp(argv[i], "--shift-time") == 0 && i + 1 < argc) {
+            opts.shift[metric_time] = std::atof(argv[++i]);
+        } else if(std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_files.push_back(argv[++i]);
+        } else if(std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_dir = argv[++i];
+        } else if(argv[i][0] == '-') {
+            print_usage();
+            return 1;
+        } else {
+            logs.push_back(argv[i]);
+        }
+    }
+    if(logs.empty())
+    {
+        print_usage();
+        return 1;
+    }
+
+    std::vector<json> records;
+    for(const std::string& log: logs)
+    {
+        std::ifstream in(log);
+        if(!in)
+        {
+            std::cerr << "cannot open file " << log << std::endl;
+            return 1;
+        }
+        read_records(in, [&records](json& rec) { records.push_back(std::move(rec)); });
+    }
+
+    std::vector<TraceData> traces;
+    for(const std::string& file: trace_files)
+    {
+        TraceData trace;
+        if(!read_trace(file, trace))
+        {
+            std::cerr << file << ": not a trace file" << std::endl;
+            return 1;
+        }
+        traces.push_back(trace);
+    }
+
+    const std::vector<ResultTable> tables = build_tables(records, opts);
+    std::vector<std::vector<json>> summaries;
+    std::vector<std::vector<PerformanceProfile>> profiles;
+    for(const ResultTable& table: tables)
+    {
+        std::vector<json> sums;
+        sums.push_back(summarize(table, -1, opts));
+        for(int b = 0; b < nsize_bucket; b++)
+            sums.push_back(summarize(table, b, opts));
+        std::vector<PerformanceProfile> profs;
+        for(int m = 0; m < nmetric; m++)
+            profs.push_back(performance_profile(table, m, opts));
+        print_summary(table, sums);
+        summaries.push_back(sums);
+        profiles.push_back(profs);
+    }
+
+    if(!out_dir.empty() && !write_outputs(out_dir, tables, summaries, profiles, traces))
+        return 1;
+
+    return 0;
+}
@@ -3,7 +3,7 @@
 
 #include "interface.h"
 
-void boxconstr_lbfgsb_stat(CUTEstStat& stat, bool verbose)
+void boxconstr_lbfgsb_stat(CUTEstStat& stat, const SolverConfig& config, bool verbose)
 {
     using Vector = Eigen::Matrix<doublereal, Eigen::Dynamic, 1>;
     using IntVector = Eigen::VectorXi;
@@ -43,19 +43,22 @@ void boxconstr_lbfgsb_stat(CUTEstStat& stat, bool verbose)
         return;
     }
     if(verbose)
-        std::cout << "nvar = " << CUTEst_nvar << std::endl;
+        std::cerr << "nvar = " << CUTEst_nvar << std::endl;
 
     // Reserve memory for variables, bounds, and multipliers,
     // and call appropriate initialization routine for CUTEst
     Vector x(CUTEst_nvar);
     Vector lb(CUTEst_nvar);
     Vector ub(CUTEst_nvar);
-    // FORTRAN unit number for error output
-    integer iout = 6;
+    // FORTRAN unit number for error output, see FortranMessages
+    const FortranMessages messages("Classic");
+    integer iout = messages.unit();
     // FORTRAN unit internal input/output
     integer io_buffer = 11;
+    const double setup_start = WallCpuTime::now().wall;
     CUTEST_usetup(&status, &funit, &iout, &io_buffer,
                   &CUTEst_nvar, x.data(), lb.data(), ub.data());
+    const double setup_end = WallCpuTime::now().wall;
     if(status)
     {
         stat.flag = 2;
@@ -65,9 +68,9 @@ void boxconstr_lbfgsb_stat(CUTEstStat& stat, bool verbose)
     }
     if(verbose)
     {
-        std::cout << "x0 = " <<  x.transpose().head(10) << " ... " <<  x.transpose().tail(10) << std::endl;
-        std::cout << "lb = " << lb.transpose().head(10) << " ... " << lb.transpose().tail(10) << std::endl;
-        std::cout << "ub = " << ub.transpose().head(10) << " ... " << ub.transpose().tail(10) << std::endl << std::endl;
+        std::cerr << "x0 = " <<  x.transpose().head(10) << " ... " <<  x.transpose().tail(10) << std::endl;
+        std::cerr << "lb = " << lb.transpose().head(10) << " ... " << lb.transpose().tail(10) << std::endl;
+        std::cerr << "ub = " << ub.transpose().head(10) << " ... " << ub.transpose().tail(10) << std::endl << std::endl;
     }
 
     // Problem name
@@ -81,13 +84,14 @@ void boxconstr_lbfgsb_stat(CUTEstStat& stat, bool verbose)
         CUTEST_uterminate(&status);
         return;
     }
+    progress_start("L-BFGS-B", "Classic", prob_name, CUTEst_nvar);
 
     // Algorithm parameters
-    const integer param_m = 6;
-    const integer param_maxit = 10000;
+    const integer param_m = config.get("m", 6);
+    const integer param_maxit = config.get("max_iterations", 10000);
     // const doublereal param_factr = 0.0;
-    const doublereal param_factr = 1e7;
-    const doublereal param_pgtol = 1e-5;
+    const doublereal param_factr = config.get("factr", 1e7);
+    const doublereal param_pgtol = config.get("epsilon", 1e-5);
 
     // Bound type indicators
     IntVector nbd(CUTEst_nvar);
@@ -119,57 +123,154 @@ void boxconstr_lbfgsb_stat(CUTEstStat& stat, bool verbose)
     integer isave[44];
     double dsave[29];
 
-    // Optimization process
-    itask = 2;
-    int i = 0;
-    while (i < param_maxit)
-    {
-        // Call L-BFGS-B routine
-        setulb_(&CUTEst_nvar, &param_m, x.data(), lb.data(), ub.data(), nbd.data(),
-            &fx, grad.data(), &param_factr, &param_pgtol,
-            wa.data(), iwa.data(), &itask, &iprint,
-            &icsave, lsave, isave, dsave);
-
-        // std::cout << "i = " << i << ", itask = " << itask << std::endl;
-        if (itask == 4 || itask == 20 || itask == 21)
+    // Trace of the solve, if requested
+    std::unique_ptr<TraceWriter> trace = open_trace(config, "L-BFGS-B", "Classic", prob_name, CUTEst_nvar);
+    fun.set_trace(trace.get());
+    // Timeline of the solve, if requested
+    std::unique_ptr<TimelineWriter> timeline = open_timeline(config, "L-BFGS-B", "Classic", prob_name, setup_start);
+    if(timeline)
+        timeline->span("setup", setup_start, setup_end);
+    fun.set_timeline(timeline.get());
+    TimelineWriter* steps = timeline.get();
+
+    // Wall time of the evaluations in the line searches, which mainlb
+    // includes in its line search time, and number of bounds entering or
+    // leaving the active set at the Cauchy points
+    double linesearch_oracle;
+    int active_changes;
+
+    // Optimization process, starting from x
+    // Returns the number of iterations, and false in ok if some error occurs
+    auto solve = [&](bool& ok) {
+        itask = 2;
+        // mainlb only reads its clocks for the phase times (dsave(7:9))
+        // if isave(24) is set
+        isave[23] = (config.get("phases", 0) > 0) ? 1 : 0;
+        ok = true;
+        linesearch_oracle = 0.0;
+        active_changes = 0;
+        int i = 0;
+        while (i < param_maxit)
         {
-            // Compute objective function value and gradient
-            fx = fun(x, grad);
-            // std::cout << "   x    = " <<  x.transpose() << std::endl;
-            // std::cout << "   grad = " <<  grad.transpose() << std::endl;
-            // std::cout << "   fx   = " <<  fx << std::endl;
-        } else if (itask >= 6 && itask <= 8) {
-            // Converged
-            break;
-        } else if (itask == 1) {
-            // New x, update iteration number
-            i = isave[29];
-        } else {
-            // Errors
-            stat.prob = std::string(prob_name);
-            stat.nvar = CUTEst_nvar;
-            stat.flag = 1;
-            stat.msg = std::string("Solver abnormal exit. itask = ") +
-                std::to_string(itask);
-            CUTEST_uterminate(&status);
-            return;
+            // Call L-BFGS-B routine
+            const double step_start = steps ? WallCpuTime::now().wall : 0.0;
+            setulb_(&CUTEst_nvar, &param_m, x.data(), lb.data(), ub.data(), nbd.data(),
+                &fx, grad.data(), &param_factr, &param_pgtol,
+                wa.data(), iwa.data(), &itask, &iprint,
+                &icsave, lsave, isave, dsave);
+            if (steps)
+                steps->span("setulb", step_start, WallCpuTime::now().wall, "itask", itask);
+
+            // std::cout << "i = " << i << ", itask = " << itask << std::endl;
+            if (itask == 4 || itask == 20 || itask == 21)
+            {
+                // Compute objective function value and gradient
+                const double oracle_start = fun.oracle_time().wall;
+                fx = fun(x, grad);
+                if (itask == 20)
+                    linesearch_oracle += fun.oracle_time().wall - oracle_start;
+                // std::cout << "   x    = " <<  x.transpose() << std::endl;
+                // std::cout << "   grad = " <<  grad.transpose() << std::endl;
+                // std::cout << "   fx   = " <<  fx << std::endl;
+            } else if (itask >= 6 && itask <= 8) {
+                // Converged
+                break;
+            } else if (itask == 1) {
+                // New x, update iteration number
+                i = isave[29];
+                progress_iter(i);
+                // Projected gradient norm, step length and number of
+                // active constraints of the iteration
+                fun.trace_iteration(i, dsave[12], dsave[13], isave[38]);
+                // Variables leaving and entering the active set
+                active_changes += (CUTEst_nvar + 1 - isave[39]) + isave[40];
+            } else {
+                ok = false;
+                break;
+            }
         }
+        return i;
+    };
+    const Vector x0 = x;
+    bool ok;
+    // Hardware counters, if requested
+    PerfCounters solve_perf(config.get("perf", 0) > 0), oracle_perf(config.get("perf", 0) > 1);
+    if(oracle_perf.available())
+        fun.set_oracle_counters(&oracle_perf);
+    MemoryMeter memory;
+    // Sampling profile, if requested
+    Profiler profiler(config.get("profile", 0));
+    memory.start();
+    profiler.start();
+    solve_perf.start();
+    const WallCpuTime start = WallCpuTime::now();
+    const int i = solve(ok);
+    const WallCpuTime loop_time = WallCpuTime::now() - start;
+    solve_perf.stop();
+    profiler.stop();
+    const MemoryUsage memory_usage = memory.stop();
+    fun.set_oracle_counters(NULL);
+    fun.set_trace(NULL);
+    fun.set_timeline(NULL);
+    steps = NULL;
+    if(timeline)
+        timeline->span("solve", start.wall, start.wall + loop_time.wall);
+    if (!ok)
+    {
+        // Errors
+        stat.prob = std::string(prob_name);
+        stat.nvar = CUTEst_nvar;
+        stat.flag = 1;
+        stat.msg = std::string("Solver abnormal exit. itask = ") +
+            std::to_string(itask);
+        CUTEST_uterminate(&status);
+        return;
     }
 
     doublereal calls[4], time[2];
     CUTEST_ureport(&status, calls, time);
 
     if(verbose)
-        std::cout << "x = " << x.transpose().head(5) << " ... " << x.transpose().tail(5) << std::endl << std::endl;
+        std::cerr << "x = " << x.transpose().head(5) << " ... " << x.transpose().tail(5) << std::endl << std::endl;
 
     stat.prob = std::string(prob_name);
     stat.nvar = CUTEst_nvar;
     stat.niter = i;
     stat.nfun = calls[0];
+    stat.ngrad = calls[1];
+    stat.nhess = calls[2];
+    stat.nhprod = calls[3];
     stat.objval = fx;
     stat.proj_grad = dsave[12];
     stat.setup_time = time[0];
     stat.solve_time = time[1];
+    stat.oracle_time = fun.oracle_time();
+    stat.solver_time = loop_time - stat.oracle_time;
+    stat.perf = perf_to_json(solve_perf, oracle_perf);
+    stat.memory = memory_usage;
+    stat.profile = profiler.write_folded("profile_Classic.folded");
+    stat.workspace = wa.size() * sizeof(doublereal) + iwa.size() * sizeof(integer);
+    // Phase times measured by mainlb (dsave(7:9)), and statistics of the
+    // BFGS updates (isave(31), isave(26)) and Cauchy point searches (isave(22))
+    if(config.get("phases", 0) > 0)
+    {
+        stat.phases = {
+            {"cauchy", dsave[6]},
+            {"subspace", dsave[7]},
+            {"linesearch", dsave[8] - linesearch_oracle},
+            {"nupdate", isave[30]},
+            {"nskip", isave[25]},
+            {"nsegment", isave[21]},
+            {"active_changes", active_changes}
+        };
+    }
+
+    // Repeated timing, after the counters of CUTEst have been read
+    if(repeat_timing_enabled(config))
+        stat.timing = time_repeated([&]() { x = x0; bool rep_ok; solve(rep_ok); return true; }, config);
 
+    const double teardown_start = WallCpuTime::now().wall;
     CUTEST_uterminate(&status);
+    if(timeline)
+        timeline->span("teardown", teardown_start, WallCpuTime::now().wall);
 }
@@ -0,0 +1,159 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <fstream>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "cache.h"
+#include "sha256.h"
+#include "paths.h"
+
+using json = nlohmann::json;
+
+// Version of the key layout, bumped whenever the key composition changes
+static const char cache_version[] = "cutest-lbfgs-cache-4";
+
+// Decoded problem files that determine the problem
+static const char* problem_files[] = {
+    "ELFUN.f", "EXTER.f", "GROUP.f", "RANGE.f", "OUTSDIF.d"
+};
+
+// Object files linked into run.out for each solver that determine its
+// results, see the Makefile. Code that only formats the records (stat.o,
+// results.o) or describes the build (provenance.o, which changes with the
+// LBFGS++ revision) is left out, so that e.g. updating LBFGS++ keeps the
+// results of the Classic solvers; changes of the record layout bump
+// cache_version instead
+static std::vector<std::string> solver_objects(const std::string& category, const std::string& solver)
+{
+    std::vector<std::string> obj;
+    if(category == "unconstr" && solver == "Classic")
+        obj = { "lbfgs.o", "unconstr_lbfgs_interface.o" };
+    else if(category == "unconstr" && solver == "LBFGS++")
+        obj = { "unconstr_lbfgspp_interface.o" };
+    else if(category == "boxconstr" && solver == "Classic")
+        obj = { "blas.o", "lbfgsb.o", "linpack.o", "timer.o", "boxconstr_lbfgsb_interface.o" };
+    else if(category == "boxconstr" && solver == "LBFGS++")
+        obj = { "boxconstr_lbfgspp_interface.o" };
+    else
+        return obj;
+
+    // Code shared by all solvers
+    obj.push_back("interface.o");
+    obj.push_back("progress.o");
+    obj.push_back("param.o");
+    obj.push_back("timing.o");
+    obj.push_back("perf.o");
+    obj.push_back("trace.o");
+    obj.push_back("memory.o");
+    obj.push_back("alloc.o");
+    obj.push_back("timeline.o");
+    obj.push_back("profile.o");
+    obj.push_back("run_" + category + ".o");
+    return obj;
+}
+
+ResultCache::ResultCache(const std::string& dir, const std::string& objdir) :
+    m_dir(dir), m_objdir(objdir)
+{
+    mkdir(m_dir.c_str(), 0755);
+}
+
+std::string ResultCache::solver_hash(const std::string& category, const std::string& solver)
+{
+    const std::string id = category + "/" + solver;
+    std::map<std::string, std::string>::const_iterator it = m_solver_hash.find(id);
+    if(it != m_solver_hash.end())
+        return it->second;
+
+    std::vector<std::string> obj = solver_objects(category, solver);
+    std::string digest;
+    if(!obj.empty())
+    {
+        SHA256 sha;
+        sha.update(id + '\n');
+        bool ok = true;
+        for(const std::string& name: obj)
+        {
+            SHA256 file;
+            ok = ok && file.update_file(m_objdir + "/" + name);
+            sha.update(name + ' ' + file.hexdigest() + '\n');
+        }
+        if(ok)
+            digest = sha.hexdigest();
+    }
+    m_solver_hash[id] = digest;
+    return digest;
+}
+
+std::string ResultCache::entry_path(const std::string& key) const
+{
+    return m_dir + "/" + key.substr(0, 2) + "/" + key + ".json";
+}
+
+std::string ResultCache::key(const SuiteJob& job)
+{
+    const std::string category = problem_category(job.path);
+    if(category.empty() || job.solver.empty())
+        return "";
+    const std::string solver = solver_hash(category, job.solver);
+    if(solver.empty())
+        return "";
+
+    SHA256 sha;
+    sha.update(std::string(cache_version) + '\n');
+    sha.update("solver " + solver + '\n');
+    // Parameters that are not set keep the defaults compiled into the
+    // interfaces, which are covered by the solver hash. The config is
+    // hashed whole, so a cached record has exactly the config of the job
+    if(job.config.is_object() && !job.config.empty())
+        sha.update("config " + job.config.dump() + '\n');
+    for(const char* name: problem_files)
+    {
+        SHA256 file;
+        if(!file.update_file(job.path + "/" + name))
+            return "";
+        sha.update(std::string(name) + ' ' + file.hexdigest() + '\n');
+    }
+    return sha.hexdigest();
+}
+
+bool ResultCache::lookup(const std::string& key, std::vector<json>& records) const
+{
+    std::ifstream in(entry_path(key));
+    if(!in)
+        return false;
+    try {
+        json entry = json::parse(in);
+        records.clear();
+        for(const json& rec: entry)
+            records.push_back(rec);
+    } catch (json::exception&) {
+        // Corrupted entry, treated as missing
+        return false;
+    }
+    return !records.empty();
+}
+
+bool ResultCache::store(const std::string& key, const std::vector<json>& records) const
+{
+    const std::string path = entry_path(key);
+    mkdir((m_dir + "/" + key.substr(0, 2)).c_str(), 0755);
+
+    // Write to a temporary file and rename, so that readers never see
+    // a partially written entry
+    const std::string tmp = path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream out(tmp);
+        if(!out)
+            return false;
+        out << json(records).dump(2) << std::endl;
+        if(!out)
+        {
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,47 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_CACHE_H
+#define CUTEST_CACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "suite.h"
+
+// Content-addressed store of solver results
+//
+// The key of a (problem, solver) pair is a SHA-256 hash of the decoded
+// problem files (ELFUN.f, EXTER.f, GROUP.f, RANGE.f, OUTSDIF.d) and of the
+// object files that make up the solver and its interface, plus the solver
+// parameters given at run time. The default parameters are compiled into
+// the interface objects, so changing them, or upgrading LBFGS++, only
+// invalidates the results of the affected solver.
+// Results are stored as DIR/xx/<key>.json
+class ResultCache
+{
+private:
+    std::string m_dir;       // Cache directory
+    std::string m_objdir;    // Directory containing the solver object files
+    std::map<std::string, std::string> m_solver_hash;  // Memoized solver hashes
+
+    std::string solver_hash(const std::string& category, const std::string& solver);
+    std::string entry_path(const std::string& key) const;
+
+public:
+    ResultCache(const std::string& dir, const std::string& objdir = ".");
+
+    // Compute the key of a job, or return an empty string if some of the
+    // files cannot be read, in which case the job is not cached
+    std::string key(const SuiteJob& job);
+
+    // Retrieve the stored records of a key, returning false if not present
+    bool lookup(const std::string& key, std::vector<nlohmann::json>& records) const;
+
+    // Store the records of a key, returning false on failure
+    bool store(const std::string& key, const std::vector<nlohmann::json>& records) const;
+};
+
+
+#endif  // CUTEST_CACHE_H
@@ -0,0 +1,164 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <cstdlib>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include "cachegrind.h"
+
+using json = nlohmann::json;
+
+std::string find_in_path(const std::string& name)
+{
+    const char* env = std::getenv("PATH");
+    if(env == NULL)
+        return "";
+    std::istringstream dirs(env);
+    std::string dir;
+    while(std::getline(dirs, dir, ':'))
+    {
+        if(dir.empty())
+            continue;
+        const std::string path = dir + "/" + name;
+        if(access(path.c_str(), X_OK) == 0)
+            return path;
+    }
+    return "";
+}
+
+std::vector<std::string> cachegrind_command(const std::string& valgrind, const std::string& out_file)
+{
+    std::vector<std::string> cmd;
+    cmd.push_back(valgrind);
+    cmd.push_back("--tool=cachegrind");
+    cmd.push_back("--cache-sim=yes");
+    cmd.push_back("--cachegrind-out-file=" + out_file);
+    // Keep the messages of Valgrind out of the output of the program
+    cmd.push_back("--log-fd=2");
+    cmd.push_back("-q");
+    return cmd;
+}
+
+// Counts of one part
+struct CacheCounts
+{
+    long long instructions;
+    long long l1_misses;
+    long long ll_misses;
+
+    CacheCounts() : instructions(0), l1_misses(0), ll_misses(0) {}
+
+    json to_json() const
+    {
+        return json{ { "instructions", instructions }, { "l1_misses", l1_misses }, { "ll_misses", ll_misses } };
+    }
+};
+
+enum { PART_PROBLEM = 0, PART_CUTEST = 1, PART_SOLVER = 2 };
+
+static std::string lower(std::string str)
+{
+    for(char& c: str)
+        c = std::tolower(static_cast<unsigned char>(c));
+    return str;
+}
+
+// Part of a function, from its name and the name of its source file
+static int function_part(const std::string& fn, const std::string& fl)
+{
+    const std::string name = lower(fn), file = lower(fl);
+    // Subroutines of the problem, e.g. elfun_ and group_ compiled from
+    // ELFUN.f and GROUP.f, and the user functions of EXTER.f
+    static const char* problem_files[] = { "elfun.f", "group.f", "range.f", "exter.f" };
+    for(const char* pf: problem_files)
+    {
+        const std::size_t pos = file.rfind(pf);
+        if(pos != std::string::npos && pos + std::strlen(pf) == file.size() &&
+           (pos == 0 || file[pos - 1] == '/'))
+            return PART_PROBLEM;
+    }
+    static const char* problem_functions[] = { "elfun", "group", "range" };
+    for(const char* pf: problem_functions)
+    {
+        if(name.compare(0, std::strlen(pf), pf) == 0)
+            return PART_PROBLEM;
+    }
+    // CUTEst routines and the Fortran modules of the library
+    if(name.find("cutest") != std::string::npos || file.find("cutest") != std::string::npos)
+        return PART_CUTEST;
+    if(name.compare(0, 2, "__") == 0 && name.find("_mod_") != std::string::npos)
+        return PART_CUTEST;
+    return PART_SOLVER;
+}
+
+json read_cachegrind(const std::string& path)
+{
+    std::ifstream in(path);
+    if(!in)
+        return json();
+
+    // Columns of the events of interest, -1 if absent
+    int col_ir = -1;
+    std::vector<int> col_l1, col_ll;
+    CacheCounts parts[3];
+    std::string fl, fn, line;
+    int part = PART_SOLVER;
+    while(std::getline(in, line))
+    {
+        if(line.compare(0, 8, "events: ") == 0)
+        {
+            std::istringstream events(line.substr(8));
+            std::string event;
+            for(int i = 0; events >> event; i++)
+            {
+                if(event == "Ir")
+                    col_ir = i;
+                else if(event == "I1mr" || event == "D1mr" || event == "D1mw")
+                    col_l1.push_back(i);
+                else if(event == "ILmr" || event == "DLmr" || event == "DLmw")
+                    col_ll.push_back(i);
+            }
+        } else if(line.compare(0, 3, "fl=") == 0) {
+            fl = line.substr(3);
+            part = function_part(fn, fl);
+        } else if(line.compare(0, 3, "fn=") == 0) {
+            fn = line.substr(3);
+            part = function_part(fn, fl);
+        } else if(!line.empty() && std::isdigit(static_cast<unsigned char>(line[0]))) {
+            // Line number followed by the counts, where trailing zeros
+            // may be omitted
+            std::istringstream fields(line);
+            std::vector<long long> counts;
+            long long value;
+            fields >> value;
+            while(fields >> value)
+                counts.push_back(value);
+            auto count = [&counts](int col) {
+                return (col >= 0 && col < int(counts.size())) ? counts[col] : 0LL;
+            };
+            parts[part].instructions += count(col_ir);
+            for(int col: col_l1)
+                parts[part].l1_misses += count(col);
+            for(int col: col_ll)
+                parts[part].ll_misses += count(col);
+        }
+    }
+    if(col_ir < 0)
+        return json();
+
+    CacheCounts total;
+    for(const CacheCounts& p: parts)
+    {
+        total.instructions += p.instructions;
+        total.l1_misses += p.l1_misses;
+        total.ll_misses += p.ll_misses;
+    }
+    json res = total.to_json();
+    res["problem"] = parts[PART_PROBLEM].to_json();
+    res["cutest"] = parts[PART_CUTEST].to_json();
+    res["solver"] = parts[PART_SOLVER].to_json();
+    return res;
+}
@@ -0,0 +1,39 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_CACHEGRIND_H
+#define CUTEST_CACHEGRIND_H
+
+#include <string>
+#include <vector>
+#include "json.hpp"
+
+// Deterministic cost of a job from Cachegrind, the cache simulator of
+// Valgrind: instruction counts and simulated cache misses do not depend on
+// the load of the machine, so they can be compared across runs on shared
+// hosts where wall-clock times are too noisy
+//
+// The counts are split by function into three parts:
+//   problem  The objective function of the problem: ELFUN, GROUP, RANGE
+//            and EXTER, compiled from the SIF decoder output
+//   cutest   The rest of the CUTEst library, including CUTEST_usetup
+//   solver   Everything else: the solver, Eigen, the interface and the
+//            C, C++ and Fortran runtimes
+// The whole process is measured, so the setup of the problem is included in
+// the cutest part, and repeated timing (repeat_max) should be left off
+
+// Full path of an executable found in PATH, or an empty string
+std::string find_in_path(const std::string& name);
+
+// Command line that runs a program under Valgrind with the given full path,
+// writing the Cachegrind output to out_file
+std::vector<std::string> cachegrind_command(const std::string& valgrind, const std::string& out_file);
+
+// Summary of a Cachegrind output file, as an object with the totals
+// "instructions", "l1_misses" and "ll_misses" (instruction and data
+// misses, reads and writes), and one object with the same fields for each
+// of "problem", "cutest" and "solver". Null if the file cannot be read
+nlohmann::json read_cachegrind(const std::string& path);
+
+
+#endif  // CUTEST_CACHEGRIND_H
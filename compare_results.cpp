@@ -0,0 +1,297 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include "results.h"
+#include "analysis.h"
+
+using json = nlohmann::json;
+
+// Compare a candidate result set to a baseline, and exit with status 2 if
+// the candidate regressed
+//
+// Records are matched by problem, algorithm, solver and config. For each
+// pair, a regression is
+//   flag      The baseline has flag 0 and the candidate does not
+//   missing   The record is missing from the candidate
+//   objval    The objective value is worse than the baseline by more than
+//             ftol * max(1, |baseline|)
+//   niter     More iterations than the baseline by more than a fraction
+//   nfun      count_tol of the baseline, and by at least one
+//   time      With repeated timings in both records (the "timing" object),
+//             the confidence intervals of the medians do not overlap and
+//             the median grew by more than time_tol. Otherwise single
+//             timings are compared with the larger single_tol, and
+//             differences below time_floor seconds are ignored
+//   alloc     The candidate was built with allocation counting (the "alloc"
+//             object, see alloc.h) and allocates after the first iteration
+// Other flag changes are reported without failing the gate, and the other
+// fields are only compared when both flags are 0. The overall slowdown, the
+// ratio of the shifted geometric means of the candidate and baseline times
+// on the pairs solved by both, can also be limited with --max-slowdown
+
+struct CompareOptions
+{
+    double ftol;
+    double count_tol;
+    double time_tol;
+    double single_tol;
+    double time_floor;
+    double max_slowdown;   // 0 to disable
+    int    min_nvar;
+    std::set<std::string> solvers;
+
+    CompareOptions() :
+        ftol(1e-6), count_tol(0.1), time_tol(0.05), single_tol(0.5),
+        time_floor(1e-3), max_slowdown(0.0), min_nvar(0)
+    {}
+};
+
+void print_usage()
+{
+    std::cerr << "Usage: compare_results.out [options] BASELINE_LOG CANDIDATE_LOG" << std::endl;
+    std::cerr << "  --solver NAME        Only compare this solver, can be repeated" << std::endl;
+    std::cerr << "  --min-nvar N         Only compare problems with at least N variables" << std::endl;
+    std::cerr << "  --ftol TOL           Tolerance of objval, relative to max(1, |objval|) (default: 1e-6)" << std::endl;
+    std::cerr << "  --count-tol TOL      Relative increase of niter and nfun allowed (default: 0.1)" << std::endl;
+    std::cerr << "  --time-tol TOL       Relative increase of the median time allowed with repeated" << std::endl;
+    std::cerr << "                       timings, on top of their confidence intervals (default: 0.05)" << std::endl;
+    std::cerr << "  --single-tol TOL     Relative increase of solve_time allowed otherwise (default: 0.5)" << std::endl;
+    std::cerr << "  --time-floor SEC     Time differences below SEC are ignored (default: 0.001)" << std::endl;
+    std::cerr << "  --max-slowdown FRAC  Also fail if the ratio of the shifted geometric means of the" << std::endl;
+    std::cerr << "                       candidate and baseline times exceeds 1 + FRAC (default: 0, no limit)" << std::endl;
+    std::cerr << "  --json               Print the findings as JSON Lines instead of text" << std::endl;
+    std::cerr << "Exit status: 0 if no regression, 2 if regressions were found, 1 on errors" << std::endl;
+}
+
+// Fields of a record used in the comparison
+struct Solve
+{
+    int    nvar;
+    int    flag;
+    double objval;
+    double niter;
+    double nfun;
+    double time;        // Median of the repeated timings, or solve_time
+    bool   repeated;    // Whether the time has a confidence interval
+    double ci_lower;
+    double ci_upper;
+    double alloc_per_iter;  // Heap allocations per iteration after the
+                            // first, NaN if not counted
+};
+
+static Solve read_solve(const json& rec)
+{
+    Solve s;
+    s.nvar = int(record_number(rec.value("nvar", json())));
+    s.flag = rec.value("flag", json()).is_number_integer() ? rec["flag"].get<int>() : 1;
+    s.objval = record_number(rec.value("objval", json()));
+    s.niter = record_number(rec.value("niter", json()));
+    s.nfun = record_number(rec.value("nfun", json()));
+    s.time = record_number(rec.value("solve_time", json()));
+    s.repeated = false;
+    s.ci_lower = s.ci_upper = s.time;
+    s.alloc_per_iter = NAN;
+    const auto alloc = rec.find("alloc");
+    if(alloc != rec.end() && alloc->is_object())
+        s.alloc_per_iter = record_number(alloc->value("per_iter_count", json()));
+    const auto timing = rec.find("timing");
+    if(timing != rec.end() && timing->is_object() && timing->value("nrep", 0) > 0)
+    {
+        s.repeated = true;
+        s.time = record_number(timing->value("median", json()));
+        s.ci_lower = record_number(timing->value("ci_lower", json()));
+        s.ci_upper = record_number(timing->value("ci_upper", json()));
+    }
+    return s;
+}
+
+// (problem, alg, solver, config) -> solve, the last record of a key wins
+using SolveKey = std::vector<std::string>;
+
+static std::map<SolveKey, Solve> read_set(const std::string& path)
+{
+    std::map<SolveKey, Solve> set;
+    for(const json& rec: read_records_file(path))
+    {
+        const std::string prob = rec.value("problem", std::string());
+        if(prob.empty())
+            continue;
+        const SolveKey key = {
+            prob, rec.value("alg", std::string()), rec.value("solver", std::string()),
+            rec.contains("config") ? rec["config"].dump() : "{}"
+        };
+        set[key] = read_solve(rec);
+    }
+    return set;
+}
+
+// Whether count c grew beyond the tolerance from b
+static bool count_regressed(double b, double c, double tol)
+{
+    return std::isfinite(b) && std::isfinite(c) && c > b * (1.0 + tol) && c - b >= 1.0;
+}
+
+static bool time_regressed(const Solve& b, const Solve& c, const CompareOptions& opts)
+{
+    if(!std::isfinite(b.time) || !std::isfinite(c.time) || c.time - b.time < opts.time_floor)
+        return false;
+    if(b.repeated && c.repeated)
+        return c.ci_lower > b.ci_upper && c.time > b.time * (1.0 + opts.time_tol);
+    return c.time > b.time * (1.0 + opts.single_tol);
+}
+
+int main(int argc, char* argv[])
+{
+    CompareOptions opts;
+    bool as_json = false;
+    std::vector<std::string> logs;
+    for(int i = 1; i < argc; i++)
+    {
+        if(std::strcmp(argv[i], "--solver") == 0 && i + 1 < argc)
+        {
+            opts.solvers.insert(argv[++i]);
+        } else if(std::strcmp(argv[i], "--min-nvar") == 0 && i + 1 < argc) {
+            opts.min_nvar = std::atoi(argv[++i]);
+        } else if(std::strcmp(argv[i], "--ftol") == 0 && i + 1 < argc) {
+            opts.ftol = std::atof(argv[++i]);
+        } else if(std::strcmp(argv[i], "--count-tol") == 0 && i + 1 < argc) {
+            opts.count_tol = std::atof(argv[++i]);
+        } else if(std::strcmp(argv[i], "--time-tol") == 0 && i + 1 < argc) {
+            opts.time_tol = std::atof(argv[++i]);
+        } else if(std::strcmp(argv[i], "--single-tol") == 0 && i + 1 < argc) {
+            opts.single_tol = std::atof(argv[++i]);
+        } else if(std::strcmp(argv[i], "--time-floor") == 0 && i + 1 < argc) {
+            opts.time_floor = std::atof(argv[++i]);
+        } else if(std::strcmp(argv[i], "--max-slowdown") == 0 && i + 1 < argc) {
+            opts.max_slowdown = std::atof(argv[++i]);
+        } else if(std::strcmp(argv[i], "--json") == 0) {
+            as_json = true;
+        } else if(argv[i][0] == '-') {
+            print_usage();
+            return 1;
+        } else {
+            logs.push_back(argv[i]);
+        }
+    }
+    if(logs.size() != 2)
+    {
+        print_usage();
+        return 1;
+    }
+
+    std::map<SolveKey, Solve> baseline, candidate;
+    try {
+        baseline = read_set(logs[0]);
+        candidate = read_set(logs[1]);
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    int ncompared = 0, nregression = 0;
+    // Times of the pairs solved by both
+    std::vector<double> btime, ctime;
+    // Print a finding; regressions fail the gate
+    auto report = [&](const SolveKey& key, const std::string& kind, bool regression,
+                      double base, double cand) {
+        if(regression)
+            nregression++;
+        if(as_json)
+        {
+            json finding = {
+                {"problem", key[0]}, {"alg", key[1]}, {"solver", key[2]},
+                {"kind", kind}, {"regression", regression},
+                {"baseline", base}, {"candidate", cand}
+            };
+            if(key[3] != "{}")
+                finding["config"] = json::parse(key[3]);
+            write_record(std::cout, finding);
+        } else {
+            std::printf("%-10s %-12s %-10s %-8s %-10s %14.6g -> %-14.6g%s\n",
+                        regression ? "REGRESSED" : "changed", key[0].c_str(), key[1].c_str(),
+                        key[2].c_str(), kind.c_str(), base, cand,
+                        key[3] == "{}" ? "" : (" " + key[3]).c_str());
+        }
+    };
+
+    for(const auto& entry: baseline)
+    {
+        const SolveKey& key = entry.first;
+        const Solve& b = entry.second;
+        if(!opts.solvers.empty() && opts.solvers.count(key[2]) == 0)
+            continue;
+        if(b.nvar < opts.min_nvar)
+            continue;
+        ncompared++;
+
+        const auto it = candidate.find(key);
+        if(it == candidate.end())
+        {
+            report(key, "missing", true, b.flag, NAN);
+            continue;
+        }
+        const Solve& c = it->second;
+
+        if(b.flag != c.flag)
+        {
+            report(key, "flag", b.flag == 0, b.flag, c.flag);
+            continue;
+        }
+        // Only the outcome of failed solves is compared
+        if(b.flag != 0)
+            continue;
+
+        if(c.objval > b.objval + opts.ftol * std::max(1.0, std::abs(b.objval)) ||
+           (std::isfinite(b.objval) && !std::isfinite(c.objval)))
+            report(key, "objval", true, b.objval, c.objval);
+        if(count_regressed(b.niter, c.niter, opts.count_tol))
+            report(key, "niter", true, b.niter, c.niter);
+        if(count_regressed(b.nfun, c.nfun, opts.count_tol))
+            report(key, "nfun", true, b.nfun, c.nfun);
+        // Allocations after the warmup should stay at zero
+        if(c.alloc_per_iter > 0.0)
+            report(key, "alloc", true, b.alloc_per_iter, c.alloc_per_iter);
+        if(time_regressed(b, c, opts))
+            report(key, b.repeated && c.repeated ? "time" : "solve_time", true, b.time, c.time);
+        if(std::isfinite(b.time) && std::isfinite(c.time))
+        {
+            btime.push_back(b.time);
+            ctime.push_back(c.time);
+        }
+    }
+
+    // Ratio of the geometric means of the times, shifted in seconds so that
+    // the tiny solves do not dominate
+    const AnalysisOptions aopts;
+    double slowdown = NAN;
+    if(!btime.empty())
+    {
+        slowdown = shifted_geomean(ctime, aopts.shift[metric_time]) /
+                   shifted_geomean(btime, aopts.shift[metric_time]) - 1.0;
+        if(opts.max_slowdown > 0.0 && slowdown > opts.max_slowdown)
+        {
+            nregression++;
+            if(as_json)
+                write_record(std::cout, json{ {"kind", "slowdown"}, {"regression", true},
+                                              {"slowdown", slowdown}, {"max_slowdown", opts.max_slowdown} });
+            else
+                std::printf("%-10s overall slowdown %.1f%% > %.1f%%\n", "REGRESSED",
+                            100.0 * slowdown, 100.0 * opts.max_slowdown);
+        }
+    }
+
+    std::cerr << "# " << ncompared << " solves compared, " << nregression << " regressions";
+    if(std::isfinite(slowdown))
+        std::cerr << ", geometric mean time change " << (slowdown >= 0 ? "+" : "") << 100.0 * slowdown << "%";
+    std::cerr << std::endl;
+
+    return nregression > 0 ? 2 : 0;
+}
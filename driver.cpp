@@ -0,0 +1,241 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "interface.h"
+#include "paths.h"
+
+// Single driver for all problems
+//
+// Each problem directory contains libproblem.so, the decoded ELFUN, EXTER,
+// GROUP and RANGE routines compiled as a shared object. The driver itself
+// contains CUTEst and all solvers. CUTEst calls the problem routines ELFUN,
+// GROUP and RANGE through the forwarders below, which are bound to the
+// routines of libproblem.so when it is loaded
+//
+// CUTEst keeps global state, so every problem is run in a forked child
+//
+// With --server, the driver reads jobs from stdin, each the fields DIR and
+// ARGS... terminated by a NUL byte and followed by an empty field, so that
+// paths and configurations may contain any other character. ARGS are the
+// arguments of run.out (see parse_solver_args() in param.h). It forks one child per (problem, solver) pair. The children inherit
+// the already initialized process, so for tiny problems the cost of exec,
+// dynamic linking and Fortran runtime initialization is paid only once.
+// This is used by run_suite.out -s
+
+void print_usage()
+{
+    std::cerr << "Usage: driver.out [-d DIR]... [--config FILE] [--PARAM VALUE]... [solver...]" << std::endl;
+    std::cerr << "       driver.out --server" << std::endl;
+    std::cerr << "  -d DIR         Problem directory, can be repeated (default: current directory)" << std::endl;
+    std::cerr << "  --config FILE  JSON file of solver parameters" << std::endl;
+    std::cerr << "  --PARAM VALUE  Set a solver parameter, e.g. --m 10" << std::endl;
+    std::cerr << "  solver         Classic or LBFGS++ (default: all solvers)" << std::endl;
+}
+
+// The problem routines, with the arguments of SIFDecode. Fortran passes
+// every argument by reference, and the forwarders do not read them
+typedef void (*ElfunRoutine)(void*, void*, void*, void*, void*, void*, void*, void*,
+                             void*, void*, void*, void*, void*, void*, void*, void*,
+                             void*, void*, void*, void*, void*, void*, void*);
+typedef void (*GroupRoutine)(void*, void*, void*, void*, void*, void*, void*, void*,
+                             void*, void*, void*, void*, void*, void*, void*);
+typedef void (*RangeRoutine)(void*, void*, void*, void*, void*, void*, void*, void*, void*);
+
+static ElfunRoutine problem_elfun = NULL;
+static GroupRoutine problem_group = NULL;
+static RangeRoutine problem_range = NULL;
+
+extern "C" {
+
+void elfun_(void* fuvals, void* xvalue, void* epvalu, void* ncalcf, void* itypee,
+            void* istaev, void* ielvar, void* intvar, void* istadh, void* istepa,
+            void* icalcf, void* ltypee, void* lstaev, void* lelvar, void* lntvar,
+            void* lstadh, void* lstepa, void* lcalcf, void* lfvalu, void* lxvalu,
+            void* lepvlu, void* ifflag, void* ifstat)
+{
+    problem_elfun(fuvals, xvalue, epvalu, ncalcf, itypee, istaev, ielvar, intvar,
+                  istadh, istepa, icalcf, ltypee, lstaev, lelvar, lntvar, lstadh,
+                  lstepa, lcalcf, lfvalu, lxvalu, lepvlu, ifflag, ifstat);
+}
+
+void group_(void* gvalue, void* lgvalu, void* fvalue, void* gpvalu, void* ncalcg,
+            void* itypeg, void* istgpa, void* icalcg, void* ltypeg, void* lstgpa,
+            void* lcalcg, void* lfvalu, void* lgpvlu, void* derivs, void* igstat)
+{
+    problem_group(gvalue, lgvalu, fvalue, gpvalu, ncalcg, itypeg, istgpa, icalcg,
+                  ltypeg, lstgpa, lcalcg, lfvalu, lgpvlu, derivs, igstat);
+}
+
+void range_(void* ielemn, void* transp, void* w1, void* w2, void* nelvar,
+            void* ninvar, void* itype, void* lw1, void* lw2)
+{
+    problem_range(ielemn, transp, w1, w2, nelvar, ninvar, itype, lw1, lw2);
+}
+
+}  // extern "C"
+
+// Look up a routine of the problem, reporting an error if it is missing
+template <typename Routine>
+bool find_routine(void* handle, const char* name, Routine& routine)
+{
+    routine = reinterpret_cast<Routine>(dlsym(handle, name));
+    if(routine == NULL)
+        std::cerr << "libproblem.so: " << name << " not found" << std::endl;
+    return routine != NULL;
+}
+
+// Load the problem in the current directory and run the solvers on it
+int run_problem(const std::vector<std::string>& solvers, const SolverConfig& config)
+{
+    char cwd[PATH_MAX];
+    if(getcwd(cwd, sizeof(cwd)) == NULL)
+    {
+        std::cerr << "Cannot determine the current directory" << std::endl;
+        return 1;
+    }
+    const std::string category = problem_category(cwd);
+    if(category.empty())
+    {
+        std::cerr << cwd << ": not under problems/boxconstr or problems/unconstr" << std::endl;
+        return 1;
+    }
+
+    void* handle = dlopen("./libproblem.so", RTLD_NOW | RTLD_LOCAL);
+    if(handle == NULL)
+    {
+        std::cerr << cwd << ": " << dlerror() << std::endl;
+        return 1;
+    }
+    if(!find_routine(handle, "elfun_", problem_elfun) ||
+       !find_routine(handle, "group_", problem_group) ||
+       !find_routine(handle, "range_", problem_range))
+        return 1;
+
+    return (category == "boxconstr") ? run_boxconstr(solvers, config) : run_unconstr(solvers, config);
+}
+
+// Run the solvers on a problem in a forked child, returning the exit code
+// of the child, or -signal if it was killed
+// If pid_line is true, "#PID <pid>" is printed once the child is started
+int fork_problem(const std::string& dir, const std::vector<std::string>& solvers,
+                 const SolverConfig& config, bool pid_line)
+{
+    // Make sure buffered output is not duplicated in the child
+    std::cout.flush();
+    std::fflush(stdout);
+
+    pid_t pid = fork();
+    if(pid < 0)
+    {
+        std::cerr << "fork() failed" << std::endl;
+        return 1;
+    }
+    if(pid == 0)
+    {
+        int status = 1;
+        if(chdir(dir.c_str()) == 0)
+            status = run_problem(solvers, config);
+        else
+            std::cerr << dir << ": " << std::strerror(errno) << std::endl;
+        std::cout.flush();
+        std::exit(status);
+    }
+    if(pid_line)
+        std::cout << "#PID " << pid << std::endl;
+
+    int wstatus = 0;
+    while(waitpid(pid, &wstatus, 0) < 0 && errno == EINTR) {}
+    if(WIFEXITED(wstatus))
+        return WEXITSTATUS(wstatus);
+    return WIFSIGNALED(wstatus) ? -WTERMSIG(wstatus) : 1;
+}
+
+// Fork server loop
+int serve()
+{
+    // Initialize the Fortran I/O runtime before forking
+    const integer funit = 42;
+    integer ierr = 0;
+    FORTRAN_open(&funit, "/dev/null", &ierr);
+    if(ierr == 0)
+        FORTRAN_close(&funit, &ierr);
+
+    std::string dir, arg;
+    while(std::getline(std::cin, dir, '\0'))
+    {
+        std::vector<std::string> args, solvers;
+        while(std::getline(std::cin, arg, '\0') && !arg.empty())
+            args.push_back(arg);
+        if(dir.empty())
+            continue;
+        SolverConfig config;
+        try {
+            parse_solver_args(args, solvers, config);
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            std::cout << "#DONE 1" << std::endl;
+            continue;
+        }
+        if(solvers.empty())
+        {
+            solvers.push_back("Classic");
+            solvers.push_back("LBFGS++");
+        }
+
+        // One child per solver; report the first failure
+        int status = 0;
+        for(const std::string& s: solvers)
+        {
+            const int child = fork_problem(dir, std::vector<std::string>(1, s), config, true);
+            if(status == 0)
+                status = child;
+        }
+        std::cout << "#DONE " << status << std::endl;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc == 2 && std::strcmp(argv[1], "--server") == 0)
+        return serve();
+
+    std::vector<std::string> dirs, args, solvers;
+    for(int i = 1; i < argc; i++)
+    {
+        if(std::strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+            dirs.push_back(argv[++i]);
+        else
+            args.push_back(argv[i]);
+    }
+    SolverConfig config;
+    try {
+        parse_solver_args(args, solvers, config);
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        print_usage();
+        return 1;
+    }
+    if(dirs.empty())
+        dirs.push_back(".");
+
+    int ret = 0;
+    for(const std::string& dir: dirs)
+    {
+        if(fork_problem(dir, solvers, config, false) != 0)
+        {
+            std::cerr << dir << ": abnormal exit" << std::endl;
+            ret = 1;
+        }
+    }
+
+    return ret;
+}
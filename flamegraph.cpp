@@ -0,0 +1,153 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <map>
+#include <memory>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+// Node of the tree of call stacks
+struct StackNode
+{
+    long count;
+    std::map<std::string, std::unique_ptr<StackNode>> children;
+
+    StackNode() : count(0) {}
+};
+
+static const double svg_width = 1200.0;
+static const double frame_height = 16.0;
+static const double min_width = 0.1;   // Narrower frames are not drawn
+
+static int tree_depth(const StackNode& node)
+{
+    int depth = 0;
+    for(const auto& child: node.children)
+        depth = std::max(depth, 1 + tree_depth(*child.second));
+    return depth;
+}
+
+static std::string escape_xml(const std::string& str)
+{
+    std::string res;
+    for(char c: str)
+    {
+        switch(c)
+        {
+            case '&': res += "&amp;"; break;
+            case '<': res += "&lt;"; break;
+            case '>': res += "&gt;"; break;
+            case '"': res += "&quot;"; break;
+            default: res.push_back(c);
+        }
+    }
+    return res;
+}
+
+// Warm color derived from the name, so that a function keeps its color
+// across graphs
+static std::string frame_color(const std::string& name)
+{
+    unsigned long hash = 5381;
+    for(char c: name)
+        hash = hash * 33 + static_cast<unsigned char>(c);
+    char color[32];
+    std::snprintf(color, sizeof(color), "rgb(%d,%d,%d)", 205 + int(hash % 50),
+                  80 + int((hash / 50) % 150), 40 + int((hash / 7500) % 50));
+    return color;
+}
+
+// Draw the children of a node, starting at x, one level above y
+static void draw(std::ostream& out, const StackNode& node, double x, double y, double scale, long total)
+{
+    for(const auto& child: node.children)
+    {
+        const double width = child.second->count * scale;
+        if(width >= min_width)
+        {
+            const double top = y - frame_height;
+            out << "<g><title>" << escape_xml(child.first) << " (" << child.second->count << " samples, "
+                << 100.0 * child.second->count / total << "%)</title>"
+                << "<rect x=\"" << x << "\" y=\"" << top << "\" width=\"" << width << "\" height=\""
+                << frame_height - 1 << "\" fill=\"" << frame_color(child.first) << "\" rx=\"2\"/>";
+            // About 7 pixels per character at font-size 12
+            const std::size_t nchar = std::size_t(width / 7.0);
+            if(nchar >= 3)
+            {
+                std::string label = child.first;
+                if(label.size() > nchar)
+                    label = label.substr(0, nchar - 2) + "..";
+                out << "<text x=\"" << x + 3 << "\" y=\"" << top + frame_height - 4 << "\">"
+                    << escape_xml(label) << "</text>";
+            }
+            out << "</g>\n";
+            draw(out, *child.second, x, top, scale, total);
+        }
+        x += width;
+    }
+}
+
+// Turn collapsed stacks (see profile.h) into an SVG flame graph
+int main(int argc, char* argv[])
+{
+    if(argc != 2)
+    {
+        std::cerr << "Usage: flamegraph.out FOLDED_FILE > graph.svg" << std::endl;
+        return 1;
+    }
+
+    std::ifstream in(argv[1]);
+    if(!in)
+    {
+        std::cerr << argv[1] << ": cannot open file" << std::endl;
+        return 1;
+    }
+
+    // Each line is "root;...;leaf count"
+    StackNode root;
+    std::string line;
+    while(std::getline(in, line))
+    {
+        const std::size_t space = line.find_last_of(' ');
+        if(space == std::string::npos)
+            continue;
+        const long count = std::atol(line.c_str() + space + 1);
+        if(count <= 0)
+            continue;
+        root.count += count;
+        StackNode* node = &root;
+        std::istringstream frames(line.substr(0, space));
+        std::string frame;
+        while(std::getline(frames, frame, ';'))
+        {
+            std::unique_ptr<StackNode>& child = node->children[frame];
+            if(!child)
+                child.reset(new StackNode());
+            child->count += count;
+            node = child.get();
+        }
+    }
+    if(root.count == 0)
+    {
+        std::cerr << argv[1] << ": no samples" << std::endl;
+        return 1;
+    }
+
+    const int depth = tree_depth(root);
+    const double height = (depth + 2) * frame_height;
+    std::cout << "<?xml version=\"1.0\" standalone=\"no\"?>\n"
+              << "<svg version=\"1.1\" xmlns=\"http://www.w3.org/2000/svg\" width=\"" << svg_width
+              << "\" height=\"" << height << "\" font-family=\"monospace\" font-size=\"12\">\n"
+              << "<rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n"
+              << "<text x=\"" << svg_width / 2 << "\" y=\"" << frame_height - 3 << "\" text-anchor=\"middle\">"
+              << escape_xml(argv[1]) << " (" << root.count << " samples)</text>\n";
+    draw(std::cout, root, 0.0, height, svg_width / root.count, root.count);
+    std::cout << "</svg>" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <fstream>
+#include <cmath>
+#include <algorithm>
+#include "history.h"
+#include "results.h"
+#include "paths.h"
+
+using json = nlohmann::json;
+
+// Median of a vector, which is reordered
+static double median(std::vector<double>& x)
+{
+    if(x.empty())
+        return 0.0;
+    const std::size_t mid = x.size() / 2;
+    std::nth_element(x.begin(), x.begin() + mid, x.end());
+    return x[mid];
+}
+
+void SolveHistory::add(const std::vector<json>& records)
+{
+    for(const json& rec: records)
+    {
+        // Problem errors may be reported without a name
+        if(!rec.contains("problem") || !rec["problem"].is_string() || rec["problem"].empty())
+            continue;
+        const std::string solver = rec.value("solver", std::string());
+        const std::string config = rec.contains("config") ? rec["config"].dump() : "{}";
+        // Missing and non-finite fields count as zero
+        auto number = [&rec](const char* name) {
+            const double x = record_number(rec.value(name, json()));
+            return std::isfinite(x) ? x : 0.0;
+        };
+        Entry entry;
+        entry.time = number("setup_time") + number("solve_time");
+        entry.nvar = int(number("nvar"));
+        entry.nfun = int(number("nfun"));
+        m_entries[rec["problem"].get<std::string>()][solver][config] = entry;
+    }
+}
+
+void SolveHistory::add_file(const std::string& path)
+{
+    add(read_records_file(path));
+}
+
+double SolveHistory::known_cost(const std::string& prob, const std::string& solver) const
+{
+    const auto it = m_entries.find(prob);
+    if(it == m_entries.end())
+        return 0.0;
+    double sum = 0.0;
+    for(const auto& s: it->second)
+    {
+        if(!solver.empty() && s.first != solver)
+            continue;
+        double time = 0.0;
+        for(const auto& c: s.second)
+            time += c.second.time;
+        sum += time / s.second.size();
+    }
+    return sum;
+}
+
+double SolveHistory::estimate(const std::string& path, const std::string& solver) const
+{
+    const std::string prob = path_basename(path);
+    if(has(prob))
+        return known_cost(prob, solver);
+    if(m_entries.empty())
+        return 1.0;
+
+    // Fit the model on the solves that took a measurable time
+    std::vector<double> unit, nfun, cost;
+    std::size_t nsolver = 0;
+    for(const auto& p: m_entries)
+    {
+        cost.push_back(known_cost(p.first, solver));
+        nsolver = std::max(nsolver, p.second.size());
+        for(const auto& s: p.second)
+        {
+            for(const auto& c: s.second)
+            {
+                const Entry& e = c.second;
+                if(e.nvar > 0 && e.nfun > 0 && e.time > 0.0)
+                {
+                    unit.push_back(e.time / (double(e.nvar) * e.nfun));
+                    nfun.push_back(e.nfun);
+                }
+            }
+        }
+    }
+    const int nvar = problem_nvar(path);
+    if(nvar <= 0 || unit.empty())
+    {
+        double sum = 0.0;
+        for(double c: cost)
+            sum += c;
+        return sum / cost.size();
+    }
+    const double per_solve = median(unit) * nvar * median(nfun);
+    return solver.empty() ? per_solve * nsolver : per_solve;
+}
+
+int problem_nvar(const std::string& path)
+{
+    // The first integer of OUTSDIF.d is the number of variables, as read by
+    // CUTEST_cdimen
+    std::ifstream in(path + "/OUTSDIF.d");
+    int nvar;
+    if(!(in >> nvar))
+        return -1;
+    return nvar;
+}
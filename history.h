@@ -0,0 +1,60 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_HISTORY_H
+#define CUTEST_HISTORY_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include "json.hpp"
+
+// Solve times of past runs, used to estimate the cost of each problem
+//
+// The cost of a solver on a problem is setup_time + solve_time, averaged
+// over the configs it was run with; when a (problem, solver, config) appears
+// in several logs, the last record read is used. The cost of a problem is
+// the sum over its solvers
+//
+// Problems that were never run are estimated from their number of variables
+// with a model fitted on the history: the typical time per function
+// evaluation and variable, times the typical number of function evaluations
+class SolveHistory
+{
+private:
+    struct Entry
+    {
+        double time;         // setup_time + solve_time
+        int    nvar;         // Number of variables
+        int    nfun;         // Number of function evaluations
+    };
+
+    // Problem name -> solver -> config -> entry
+    std::map<std::string, std::map<std::string, std::map<std::string, Entry>>> m_entries;
+
+    // Cost of a problem in the history, restricted to one solver if given
+    double known_cost(const std::string& prob, const std::string& solver) const;
+
+public:
+    // Add the records of a log, as printed by run.out or run_suite.out
+    void add(const std::vector<nlohmann::json>& records);
+    // Read a log file, throwing std::runtime_error on failure
+    void add_file(const std::string& path);
+
+    bool empty() const { return m_entries.empty(); }
+    // Whether the problem appears in the history
+    bool has(const std::string& prob) const { return m_entries.count(prob) > 0; }
+
+    // Estimated cost in seconds of the problem in directory path, for the
+    // given solver or for all solvers if it is empty. Problems missing from
+    // the history use the nvar model, or the average known cost if nvar
+    // cannot be read from OUTSDIF.d, or 1 if the history is empty
+    double estimate(const std::string& path, const std::string& solver = "") const;
+};
+
+// Number of variables of the decoded problem in directory path, read from
+// the header of OUTSDIF.d, or -1 if it cannot be read
+int problem_nvar(const std::string& path);
+
+
+#endif  // CUTEST_HISTORY_H
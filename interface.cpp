@@ -1,13 +1,18 @@
 // Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
 // Under MIT license
 
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "interface.h"
-#include "json.hpp"
-
-using json = nlohmann::json;
 
 // Constructor
-CUTEstProblem::CUTEstProblem(integer n_) : n(n_) {}
+CUTEstProblem::CUTEstProblem(integer n_) : n(n_), niter(0), eval_time(), perf(NULL), trace(NULL), lb(NULL), ub(NULL),
+    neval(0), neval_iter(0), last_f(0.0), last_gnorm(0.0), phases(NULL), phase_mark(0.0), oracle_mark(0.0),
+    allocs(NULL), timeline(NULL), linesearch_begin(0.0)
+{}
 
 // Compute objective function value and gradient
 doublereal CUTEstProblem::operator()(const Vector& x, Vector& grad)
@@ -15,48 +20,117 @@ doublereal CUTEstProblem::operator()(const Vector& x, Vector& grad)
     integer status;  // Exit flag from CUTEst tools
     logical comp_grad = 1;  // Compute gradient
     doublereal fx;
+    // Allocations of CUTEst are not attributed to the solver
+    const bool counting = allocs && alloc_count_enable(false);
+    if(perf)
+        perf->start();
+    const WallCpuTime start = WallCpuTime::now();
     CUTEST_uofg(&status, &n, x.data(), &fx, grad.data(), &comp_grad);
+    const WallCpuTime end = WallCpuTime::now();
+    eval_time += end - start;
+    if(perf)
+        perf->stop();
     if(status)
     {
         throw std::runtime_error("** CUTEst error");
     }
+    progress_eval(fx);
+    neval++;
+    if(timeline)
+        timeline->span("oracle", start.wall, end.wall, "eval", neval);
+    last_f = fx;
+    if(trace)
+    {
+        last_gnorm = grad.norm();
+        trace->evaluation(fx, last_gnorm);
+    }
+    if(counting)
+        alloc_count_enable(true);
     return fx;
 }
 
-// Trim trailing whitespace
-inline std::string trim_space(const std::string& name)
+nlohmann::json alloc_to_json(const AllocStats& stats)
 {
-    std::size_t trim = name.find_last_not_of(' ');
-    return name.substr(0, trim + 1);
+    if(!alloc_count_available())
+        return nlohmann::json();
+    const AllocCounts steady = stats.total - stats.warmup;
+    const int nsteady = std::max(stats.niter - 1, 1);
+    return {
+        {"count", stats.total.count},
+        {"bytes", stats.total.bytes},
+        {"warmup_count", stats.warmup.count},
+        {"warmup_bytes", stats.warmup.bytes},
+        {"per_iter_count", double(steady.count) / nsteady},
+        {"per_iter_bytes", double(steady.bytes) / nsteady}
+    };
 }
 
-void print_stat(const CUTEstStat& stat)
+FortranMessages::FortranMessages(const char* solver) :
+    m_unit(0), m_path(std::string("messages_") + solver + ".log")
 {
-    std::cout << "Problem               = " << stat.prob << std::endl;
-    std::cout << "Flag                  = " << stat.flag << std::endl;
-    std::cout << "# variables           = " << stat.nvar << std::endl;
-    std::cout << "# iterations          = " << stat.niter << std::endl;
-    std::cout << "# function calls      = " << stat.nfun << std::endl;
-    std::cout << "Final f               = " << stat.objval << std::endl;
-    std::cout << "Final ||proj_grad||   = " << stat.proj_grad << std::endl;
-    std::cout << "Setup time            = " << stat.setup_time << " s" << std::endl;
-    std::cout << "Solve time            = " << stat.solve_time << " s" << std::endl;
+    // The unit is opened with STATUS='OLD', so the file is created empty first
+    if(!std::ofstream(m_path))
+        return;
+    const integer unit = 7;
+    integer ierr = 0;
+    FORTRAN_open(&unit, m_path.c_str(), &ierr);
+    if(ierr == 0)
+        m_unit = unit;
+    else
+        std::remove(m_path.c_str());
 }
 
-// Convert CUTEstStat object to JSON
-json stat_to_json(const CUTEstStat& stat)
+FortranMessages::~FortranMessages()
 {
-    json data = {
-        {"problem", trim_space(stat.prob)},
-        {"flag", stat.flag},
-        {"msg", stat.msg},
-        {"nvar", stat.nvar},
-        {"niter", stat.niter},
-        {"nfun", stat.nfun},
-        {"objval", stat.objval},
-        {"proj_grad", stat.proj_grad},
-        {"setup_time", stat.setup_time},
-        {"solve_time", stat.solve_time}
-    };
-    return data;
+    if(m_unit <= 0)
+        return;
+    integer ierr = 0;
+    FORTRAN_close(&m_unit, &ierr);
+    struct stat st;
+    if(stat(m_path.c_str(), &st) == 0 && st.st_size == 0)
+        std::remove(m_path.c_str());
+}
+
+std::string problem_dir_name()
+{
+    char cwd[4096];
+    if(getcwd(cwd, sizeof(cwd)) == NULL)
+        return "";
+    const std::string dir(cwd);
+    return dir.substr(dir.find_last_of('/') + 1);
+}
+
+std::unique_ptr<TraceWriter> open_trace(const SolverConfig& config, const char* alg, const char* solver,
+                                        const char* prob, int nvar)
+{
+    std::unique_ptr<TraceWriter> trace;
+    if(config.get("trace", 0) > 0)
+    {
+        trace.reset(new TraceWriter(std::string("trace_") + solver + ".bin", alg, solver, prob, nvar));
+        if(!trace->is_open())
+        {
+            std::cerr << "Cannot create the trace file of " << solver << std::endl;
+            trace.reset();
+        }
+    }
+    return trace;
+}
+
+std::unique_ptr<TimelineWriter> open_timeline(const SolverConfig& config, const char* alg, const char* solver,
+                                              const char* prob, double origin)
+{
+    std::unique_ptr<TimelineWriter> timeline;
+    if(config.get("timeline", 0) > 0)
+    {
+        // prob is padded with spaces by CUTEst
+        std::string name = std::string(alg) + " " + solver + " " + prob;
+        name.erase(name.find_last_not_of(' ') + 1);
+        timeline.reset(new TimelineWriter(std::string("timeline_") + solver + ".json", name, origin));
+        if(!timeline->is_open())
+        {
+            std::cerr << "Cannot create the timeline file of " << solver << std::endl;
+            timeline.reset();
+        }
+    }
+    return timeline;
 }
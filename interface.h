@@ -6,8 +6,20 @@
 
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include <vector>
+#include <memory>
+#include <limits>
 #include <Eigen/Core>
 #include "json.hpp"
+#include "stat.h"
+#include "progress.h"
+#include "param.h"
+#include "perf.h"
+#include "trace.h"
+#include "alloc.h"
+#include "timeline.h"
+#include "profile.h"
 
 extern "C" {
 
@@ -23,6 +35,13 @@ void lbfgs_(
     double* w, int* iflag
 );
 
+// Line search parameters of L-BFGS, COMMON /LB3/ in lbfgs.f
+extern struct
+{
+    int    mp, lp;
+    double gtol, stpmin, stpmax;
+} lb3_;
+
 // Fortran L-BFGS-B function
 void setulb_(
     const int* n, const int* m,
@@ -36,44 +55,261 @@ void setulb_(
 
 }
 
+// Phases of the LBFGS++ solvers, timed from the line searches: LBFGS++
+// does not expose its Cauchy point and subspace minimization, so the time
+// between two line searches (BFGS update, convergence tests, Cauchy point
+// and subspace minimization) is reported as a single phase. All times are
+// wall-clock seconds, excluding the evaluations
+struct PhaseTimes
+{
+    double linesearch;       // Line searches
+    double direction;        // Computation of the search directions
+    int    active_changes;   // Number of bounds entering or leaving the
+                             // active set between consecutive iterates
+
+    PhaseTimes() : linesearch(0.0), direction(0.0), active_changes(0) {}
+};
+
+// Heap allocations of the LBFGS++ solvers in the ALLOC_COUNT build (see
+// alloc.h), excluding those of the evaluations and of CUTEstProblem itself
+struct AllocStats
+{
+    AllocCounts total;       // Whole solve
+    AllocCounts warmup;      // Up to the end of the first iteration
+    int         niter;       // Number of iterations
+
+    AllocStats() : niter(0) {}
+};
+
 // Problem class
 class CUTEstProblem
 {
 private:
     using Vector = Eigen::Matrix<doublereal, Eigen::Dynamic, 1>;
-    integer n;
+    integer     n;
+    int         niter;
+    WallCpuTime eval_time;   // Time spent in CUTEST_uofg
+    PerfCounters* perf;      // Counters enabled during evaluations, or NULL
+    TraceWriter* trace;      // Trace of evaluations and iterations, or NULL
+    const Vector* lb;        // Bounds used for the projected gradient in the
+    const Vector* ub;        // trace, NULL if unconstrained
+    int         neval;       // Number of evaluations
+    int         neval_iter;  // Number of evaluations at the last iteration
+    doublereal  last_f;      // Last objective function value
+    doublereal  last_gnorm;  // 2-norm of the last gradient, if traced
+    PhaseTimes* phases;      // Phase times, or NULL
+    double      phase_mark;  // Wall time and oracle wall time at the start
+    double      oracle_mark; // of the current phase
+    std::vector<char> active;  // Active bounds of the last iterate
+    AllocStats* allocs;      // Allocation counts, or NULL
+    AllocCounts alloc_base;  // Allocations of the thread before the solve
+    TimelineWriter* timeline;  // Timeline of evaluations and line searches, or NULL
+    double      linesearch_begin;  // Start of the current line search, if timeline is set
+
+    // End the current phase, returning its time excluding the evaluations
+    double phase_end()
+    {
+        const double now = WallCpuTime::now().wall, oracle = eval_time.wall;
+        const double elapsed = (now - phase_mark) - (oracle - oracle_mark);
+        phase_mark = now;
+        oracle_mark = oracle;
+        return elapsed;
+    }
+
+    // Update the active bounds with those of x, counting the changes
+    void count_active_changes(const Vector& x)
+    {
+        const bool first = active.empty();
+        active.resize(x.size(), 0);
+        for(int i = 0; i < int(x.size()); i++)
+        {
+            const char at_bound = (x[i] <= (*lb)[i] || x[i] >= (*ub)[i]);
+            if(!first && at_bound != active[i])
+                phases->active_changes++;
+            active[i] = at_bound;
+        }
+    }
 public:
     CUTEstProblem(integer n_);
 
     doublereal operator()(const Vector& x, Vector& grad);
+
+    // Accumulated time of the evaluations
+    const WallCpuTime& oracle_time() const { return eval_time; }
+
+    // Count the evaluations with these counters, see perf.h
+    void set_oracle_counters(PerfCounters* counters) { perf = counters; }
+
+    // Record the evaluations and iterations in a trace, see trace.h
+    void set_trace(TraceWriter* writer, const Vector* lower = NULL, const Vector* upper = NULL)
+    {
+        trace = writer;
+        lb = lower;
+        ub = upper;
+    }
+
+    // Add an iteration ending at the last evaluation to the trace, with the
+    // given (projected) gradient norm, step and active bound count
+    void trace_iteration(int iter, double gnorm, double step, int nactive)
+    {
+        if(trace)
+            trace->iteration(iter, last_f, gnorm, step, neval - neval_iter, nactive);
+        neval_iter = neval;
+    }
+    // Same, with the values of the last evaluation, for the Classic L-BFGS
+    // whose step length is not exposed
+    void trace_iteration(int iter)
+    {
+        trace_iteration(iter, last_gnorm, std::numeric_limits<double>::quiet_NaN(), -1);
+    }
+
+    // Time the phases of the LBFGS++ solvers from now on, see PhaseTimes
+    void set_phases(PhaseTimes* times)
+    {
+        phases = times;
+        active.clear();
+        if(phases)
+            phase_end();
+    }
+
+    // Record the evaluations, and the line searches of LBFGS++, in a timeline
+    void set_timeline(TimelineWriter* writer) { timeline = writer; }
+
+    // Count the heap allocations from now on, if alloc_count_available(),
+    // until this is called again with NULL
+    void set_alloc_counting(AllocStats* stats)
+    {
+        if(stats)
+        {
+            allocs = stats;
+            *allocs = AllocStats();
+            alloc_base = alloc_count_read();
+            alloc_count_enable(true);
+        } else if(allocs) {
+            alloc_count_enable(false);
+            allocs->total = alloc_count_read() - alloc_base;
+            allocs = NULL;
+        }
+    }
+
+    // Called by the LBFGS++ solvers at the start of each line search
+    void linesearch_start()
+    {
+        if(phases)
+            phases->direction += phase_end();
+        if(timeline)
+            linesearch_begin = WallCpuTime::now().wall;
+    }
+
+    // Called by the LBFGS++ solvers at the end of each iteration, with the
+    // accepted step, the new point and its gradient
+    void iteration_done(doublereal step, const Vector& x, const Vector& grad)
+    {
+        const bool counting = allocs && alloc_count_enable(false);
+        if(allocs && ++allocs->niter == 1)
+            allocs->warmup = alloc_count_read() - alloc_base;
+        niter++;
+        progress_iter(niter);
+        if(timeline)
+            timeline->span("linesearch", linesearch_begin, WallCpuTime::now().wall, "iter", niter);
+        if(phases)
+        {
+            phases->linesearch += phase_end();
+            if(lb && ub)
+                count_active_changes(x);
+        }
+        if(trace)
+        {
+            if(lb && ub)
+            {
+                int nactive;
+                const double gnorm = projected_grad_norm(x, grad, *lb, *ub, nactive);
+                trace_iteration(niter, gnorm, step, nactive);
+            } else {
+                trace_iteration(niter, grad.norm(), step, -1);
+            }
+        }
+        if(counting)
+            alloc_count_enable(true);
+    }
 };
 
-// Statistics
-struct CUTEstStat
+// Allocation counts for the "alloc" field of a record: totals, the warmup
+// up to the end of the first iteration, and the average per iteration after
+// it, which should be zero. Null if counting is not available
+nlohmann::json alloc_to_json(const AllocStats& stats);
+
+// Fortran unit for the messages of CUTEst and of the Classic solvers during
+// a solve, connected to messages_<solver>.log in the problem directory.
+// stdout only carries the records, and the Fortran runtime cannot connect a
+// unit to stderr without overwriting it when it is redirected to a file.
+// The file is removed at the end of the solve if nothing was written to it.
+// unit() is 0, which silences the messages, if it cannot be created
+class FortranMessages
 {
-    std::string prob;        // Problem name
-    int         flag;        // 0-normal, 1-solver error, 2-problem error
-    std::string msg;         // Error message
-    int         nvar;        // Number of variables
-    int         niter;       // Number of iterations
-    int         nfun;        // Number of function evluations
-    double      objval;      // Final objective function value
-    double      proj_grad;   // Final (projected) gradient
-    double      setup_time;  // Time for setup
-    double      solve_time;  // Time for solving
+private:
+    integer     m_unit;
+    std::string m_path;
+
+    FortranMessages(const FortranMessages&);
+    FortranMessages& operator=(const FortranMessages&);
+public:
+    explicit FortranMessages(const char* solver);
+    ~FortranMessages();
+
+    integer unit() const { return m_unit; }
 };
 
-// Interface
-void unconstr_lbfgs_stat(CUTEstStat& stat, bool verbose = false);
-void unconstr_lbfgspp_stat(CUTEstStat& stat, bool verbose = false);
-void boxconstr_lbfgsb_stat(CUTEstStat& stat, bool verbose = false);
-void boxconstr_lbfgspp_stat(CUTEstStat& stat, bool verbose = false);
+// Name of the problem directory, the working directory of run.out and
+// driver.out. Records of problems that fail before CUTEst reports their
+// name are identified by it
+std::string problem_dir_name();
+
+// Open the trace of a solve, trace_<solver>.bin in the problem directory,
+// if the trace parameter is set, or return NULL
+std::unique_ptr<TraceWriter> open_trace(const SolverConfig& config, const char* alg, const char* solver,
+                                        const char* prob, int nvar);
+
+// Open the timeline of a solve, timeline_<solver>.json in the problem
+// directory, if the timeline parameter is set, or return NULL. Times are
+// relative to origin, the wall time at the start of the setup
+std::unique_ptr<TimelineWriter> open_timeline(const SolverConfig& config, const char* alg, const char* solver,
+                                              const char* prob, double origin);
 
-// Helper functions
-void print_stat(const CUTEstStat& stat);
+// LBFGS++ only reports the number of iterations when minimize() returns,
+// but it performs exactly one line search per iteration. This wraps a
+// LBFGS++ line search so that CUTEstProblem is notified of each iteration,
+// e.g. LBFGSSolver<double, ObservedLineSearch<LineSearchNocedalWright>::type>
+template <template <class> class Base>
+struct ObservedLineSearch
+{
+    template <typename Scalar>
+    class type
+    {
+    public:
+        // The arguments of the line searches of LBFGSSolver and LBFGSBSolver
+        template <typename Param, typename Vector>
+        static void LineSearch(CUTEstProblem& f, const Param& param,
+                               const Vector& xp, const Vector& drt, const Scalar& step_max,
+                               Scalar& step, Scalar& fx, Vector& grad, Scalar& dg, Vector& x)
+        {
+            f.linesearch_start();
+            Base<Scalar>::LineSearch(f, param, xp, drt, step_max, step, fx, grad, dg, x);
+            f.iteration_done(step, x, grad);
+        }
+    };
+};
+
+// Interface
+void unconstr_lbfgs_stat(CUTEstStat& stat, const SolverConfig& config, bool verbose = false);
+void unconstr_lbfgspp_stat(CUTEstStat& stat, const SolverConfig& config, bool verbose = false);
+void boxconstr_lbfgsb_stat(CUTEstStat& stat, const SolverConfig& config, bool verbose = false);
+void boxconstr_lbfgspp_stat(CUTEstStat& stat, const SolverConfig& config, bool verbose = false);
 
-// Convert CUTEstStat object to JSON
-nlohmann::json stat_to_json(const CUTEstStat& stat);
+// Run the given solvers ("Classic", "LBFGS++", or all if empty) on the
+// problem in the current directory, and print one record per solver
+int run_unconstr(const std::vector<std::string>& solvers, const SolverConfig& config);
+int run_boxconstr(const std::vector<std::string>& solvers, const SolverConfig& config);
 
 
 #endif  // CUTEST_INTERFACE_H
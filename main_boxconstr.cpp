@@ -0,0 +1,20 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include "interface.h"
+
+// run.out of box-constrained problems
+// Solvers to run and their parameters can be given as arguments,
+// e.g. ./run.out LBFGS++ --m 10, see parse_solver_args() in param.h
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> solvers;
+    SolverConfig config;
+    try {
+        parse_solver_args(std::vector<std::string>(argv + 1, argv + argc), solvers, config);
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return run_boxconstr(solvers, config);
+}
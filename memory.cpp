@@ -0,0 +1,60 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <cstdio>
+#include <cstring>
+#include <sys/resource.h>
+#include "memory.h"
+
+// Reset the peak RSS of the process to its current RSS
+static bool reset_peak_rss()
+{
+    FILE* file = std::fopen("/proc/self/clear_refs", "w");
+    if(!file)
+        return false;
+    const bool ok = (std::fputs("5", file) >= 0);
+    return (std::fclose(file) == 0) && ok;
+}
+
+// Peak RSS in bytes from /proc/self/status, or -1
+static long read_peak_rss()
+{
+    FILE* file = std::fopen("/proc/self/status", "r");
+    if(!file)
+        return -1;
+    char line[256];
+    long kb = -1;
+    while(std::fgets(line, sizeof(line), file))
+    {
+        if(std::strncmp(line, "VmHWM:", 6) == 0)
+        {
+            std::sscanf(line + 6, "%ld", &kb);
+            break;
+        }
+    }
+    std::fclose(file);
+    return (kb < 0) ? -1 : kb * 1024;
+}
+
+void MemoryMeter::start()
+{
+    m_reset = reset_peak_rss();
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    m_minflt = usage.ru_minflt;
+    m_majflt = usage.ru_majflt;
+}
+
+MemoryUsage MemoryMeter::stop() const
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    MemoryUsage res;
+    res.minor_faults = usage.ru_minflt - m_minflt;
+    res.major_faults = usage.ru_majflt - m_majflt;
+    // ru_maxrss is in kilobytes on Linux
+    res.peak_rss = m_reset ? read_peak_rss() : -1;
+    if(res.peak_rss < 0)
+        res.peak_rss = usage.ru_maxrss * 1024;
+    return res;
+}
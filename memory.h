@@ -0,0 +1,40 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_MEMORY_H
+#define CUTEST_MEMORY_H
+
+// Memory usage of the calling process over a solve
+struct MemoryUsage
+{
+    long peak_rss;      // Peak resident set size in bytes
+    long minor_faults;  // Page faults served without I/O
+    long major_faults;  // Page faults that required I/O
+
+    MemoryUsage() : peak_rss(0), minor_faults(0), major_faults(0) {}
+};
+
+// Measure the memory usage between start() and stop(), from getrusage(2)
+//
+// The peak RSS reported by getrusage never decreases, so start() first
+// resets it through /proc/self/clear_refs (Linux 4.0 and later) and stop()
+// reads it back from VmHWM in /proc/self/status. If the reset is not
+// possible, peak_rss is the peak of the process so far, which still bounds
+// the usage of the solve. The page faults are the difference of the counts
+// at start() and stop()
+class MemoryMeter
+{
+private:
+    long m_minflt;
+    long m_majflt;
+    bool m_reset;   // Whether the peak RSS was reset by start()
+
+public:
+    MemoryMeter() : m_minflt(0), m_majflt(0), m_reset(false) {}
+
+    void start();
+    MemoryUsage stop() const;
+};
+
+
+#endif  // CUTEST_MEMORY_H
@@ -0,0 +1,133 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <iostream>
+#include <cstring>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include "results.h"
+#include "paths.h"
+
+// Combine the logs of the shards of a run (run_suite.out --shard) into
+// one result set, printed to stdout
+//
+// A record is identified by its problem, algorithm, solver and config.
+// Records seen twice are reported and only the first one is kept. A record
+// is missing if its problem (one of the -e directories, or any problem of
+// the logs) has no record for one of the solvers and configs that appear in
+// the logs. Records without a problem name, written by older versions when
+// a problem failed before CUTEst reported its name, cannot be identified:
+// they are all kept and counted separately
+//
+// Records of older logs, without "schema", are written in the current
+// schema (see upgrade_record() in results.h)
+
+void print_usage()
+{
+    std::cerr << "Usage: merge_results.out [-e DIR]... [--solver NAME]... LOG..." << std::endl;
+    std::cerr << "  -e DIR       Problem directory expected in the result set, can be repeated" << std::endl;
+    std::cerr << "  --solver     Solver expected for every problem, can be repeated" << std::endl;
+    std::cerr << "               (default: the solvers found in the logs)" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    using json = nlohmann::json;
+
+    std::vector<std::string> logs;
+    std::set<std::string> problems, solvers, configs;
+    for(int i = 1; i < argc; i++)
+    {
+        if(std::strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+        {
+            problems.insert(path_basename(argv[++i]));
+        } else if(std::strcmp(argv[i], "--solver") == 0 && i + 1 < argc) {
+            solvers.insert(argv[++i]);
+        } else if(argv[i][0] == '-') {
+            print_usage();
+            return 1;
+        } else {
+            logs.push_back(argv[i]);
+        }
+    }
+    if(logs.empty())
+    {
+        print_usage();
+        return 1;
+    }
+
+    // (problem, alg, solver, config) -> log the record came from
+    std::map<std::vector<std::string>, std::string> seen;
+    // (problem, solver, config) found in the logs
+    std::set<std::vector<std::string>> found;
+    int nrecord = 0, nduplicate = 0, nmissing = 0, nunnamed = 0, nupgraded = 0;
+    for(const std::string& log: logs)
+    {
+        std::vector<json> records;
+        try {
+            records = read_records_file(log);
+            for(json& rec: records)
+                nupgraded += upgrade_record(rec);
+        } catch (std::exception& e) {
+            std::cerr << log << ": " << e.what() << std::endl;
+            return 1;
+        }
+        for(const json& rec: records)
+        {
+            const std::string prob = rec.value("problem", std::string());
+            const std::string alg = rec.value("alg", std::string());
+            const std::string solver = rec.value("solver", std::string());
+            const std::string config = rec.contains("config") ? rec["config"].dump() : "{}";
+            if(prob.empty())
+            {
+                nunnamed++;
+            } else {
+                const std::vector<std::string> key = { prob, alg, solver, config };
+                const auto it = seen.find(key);
+                if(it != seen.end())
+                {
+                    nduplicate++;
+                    std::cerr << "# Duplicate record " << prob << " " << alg << " " << solver << " " << config
+                              << " in " << log << ", first seen in " << it->second << std::endl;
+                    continue;
+                }
+                seen[key] = log;
+                found.insert({ prob, solver, config });
+                problems.insert(prob);
+            }
+            solvers.insert(solver);
+            configs.insert(config);
+            write_record(std::cout, rec);
+            nrecord++;
+        }
+    }
+
+    // Defaults of run.out when the logs are empty
+    if(solvers.empty())
+    {
+        solvers.insert("Classic");
+        solvers.insert("LBFGS++");
+    }
+    if(configs.empty())
+        configs.insert("{}");
+    for(const std::string& prob: problems)
+    {
+        for(const std::string& solver: solvers)
+        {
+            for(const std::string& config: configs)
+            {
+                if(found.count({ prob, solver, config }))
+                    continue;
+                nmissing++;
+                std::cerr << "# Missing record " << prob << " " << solver << " " << config << std::endl;
+            }
+        }
+    }
+
+    std::cerr << "# " << logs.size() << " logs, " << nrecord << " records (" << nunnamed
+              << " without problem name, " << nupgraded << " from older logs), " << nduplicate
+              << " duplicates, " << nmissing << " missing" << std::endl;
+
+    return (nduplicate > 0 || nmissing > 0) ? 1 : 0;
+}
@@ -0,0 +1,159 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <fstream>
+#include <stdexcept>
+#include <cstdlib>
+#include "param.h"
+
+using json = nlohmann::json;
+
+// What a parameter changes
+enum ParamEffect
+{
+    param_result = 0,   // The solves or the records they produce
+    param_file          // Only files written by each solve
+};
+
+// Known parameters, whether they take integer values, and their effect
+struct ParamInfo
+{
+    const char* name;
+    bool        integer;
+    ParamEffect effect;
+};
+
+static const ParamInfo param_info[] = {
+    { "m",                    true,  param_result },
+    { "epsilon",              false, param_result },
+    { "epsilon_rel",          false, param_result },
+    { "past",                 true,  param_result },
+    { "delta",                false, param_result },
+    { "factr",                false, param_result },
+    { "max_iterations",       true,  param_result },
+    { "large_nvar",           true,  param_result },
+    { "large_max_iterations", true,  param_result },
+    { "max_linesearch",       true,  param_result },
+    { "max_submin",           true,  param_result },
+    { "gtol",                 false, param_result },
+    { "stpmin",               false, param_result },
+    { "stpmax",               false, param_result },
+    { "perf",                 true,  param_result },
+    { "trace",                true,  param_file },
+    { "phases",               true,  param_result },
+    { "timeline",             true,  param_file },
+    { "profile",              true,  param_file },
+    { "repeat_max",           true,  param_result },
+    { "repeat_min",           true,  param_result },
+    { "repeat_warmup",        true,  param_result },
+    { "repeat_rel_ci",        false, param_result },
+    { "repeat_batch_time",    false, param_result },
+    { "repeat_max_time",      false, param_result }
+};
+
+static const ParamInfo* find_param(const std::string& name)
+{
+    for(const ParamInfo& info: param_info)
+    {
+        if(name == info.name)
+            return &info;
+    }
+    return NULL;
+}
+
+std::vector<std::string> file_params(const json& config)
+{
+    std::vector<std::string> names;
+    if(!config.is_object())
+        return names;
+    for(json::const_iterator it = config.begin(); it != config.end(); ++it)
+    {
+        const ParamInfo* info = find_param(it.key());
+        if(info != NULL && info->effect == param_file && it.value().is_number() && it.value().get<double>() != 0.0)
+            names.push_back(it.key());
+    }
+    return names;
+}
+
+void SolverConfig::set(const std::string& name, const std::string& value)
+{
+    const ParamInfo* info = find_param(name);
+    if(info == NULL)
+        throw std::invalid_argument("unknown parameter " + name);
+
+    const char* begin = value.c_str();
+    char* end;
+    if(info->integer)
+    {
+        const long v = std::strtol(begin, &end, 10);
+        if(value.empty() || *end != '\0')
+            throw std::invalid_argument("parameter " + name + " needs an integer value");
+        m_values[name] = int(v);
+    } else {
+        const double v = std::strtod(begin, &end);
+        if(value.empty() || *end != '\0')
+            throw std::invalid_argument("parameter " + name + " needs a numeric value");
+        m_values[name] = v;
+    }
+}
+
+void SolverConfig::merge(const json& values)
+{
+    if(!values.is_object())
+        throw std::invalid_argument("solver configuration must be a JSON object");
+    for(json::const_iterator it = values.begin(); it != values.end(); ++it)
+    {
+        const ParamInfo* info = find_param(it.key());
+        if(info == NULL)
+            throw std::invalid_argument("unknown parameter " + it.key());
+        if(info->integer ? !it.value().is_number_integer() : !it.value().is_number())
+            throw std::invalid_argument("invalid value for parameter " + it.key());
+        m_values[it.key()] = it.value();
+    }
+}
+
+void SolverConfig::merge_file(const std::string& path)
+{
+    std::ifstream in(path);
+    if(!in)
+        throw std::invalid_argument("cannot open configuration file " + path);
+    json values;
+    try {
+        values = json::parse(in);
+    } catch (json::exception& e) {
+        throw std::invalid_argument(path + ": " + e.what());
+    }
+    merge(values);
+}
+
+void parse_solver_args(const std::vector<std::string>& args,
+                       std::vector<std::string>& solvers, SolverConfig& config)
+{
+    for(std::size_t i = 0; i < args.size(); i++)
+    {
+        const std::string& arg = args[i];
+        if(arg.compare(0, 2, "--") != 0)
+        {
+            solvers.push_back(arg);
+            continue;
+        }
+        if(i + 1 >= args.size())
+            throw std::invalid_argument("missing value for " + arg);
+
+        const std::string& value = args[++i];
+        if(arg == "--solver")
+        {
+            solvers.push_back(value);
+        } else if(arg == "--config") {
+            config.merge_file(value);
+        } else if(arg == "--config-json") {
+            try {
+                config.merge(json::parse(value));
+            } catch (json::exception& e) {
+                throw std::invalid_argument(std::string("--config-json: ") + e.what());
+            }
+        } else {
+            config.set(arg.substr(2), value);
+        }
+    }
+}
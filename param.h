@@ -0,0 +1,97 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_PARAM_H
+#define CUTEST_PARAM_H
+
+#include <string>
+#include <vector>
+#include "json.hpp"
+
+// Solver parameters set at run time
+//
+// Only the parameters that are explicitly set are stored; every solver
+// interface keeps its own defaults, which are used for the other ones.
+// Recognized parameters:
+//   m                     Number of correction pairs
+//   epsilon               Absolute tolerance on the (projected) gradient
+//   epsilon_rel           Relative tolerance on the gradient (LBFGS++)
+//   past, delta           Objective-decrease test (LBFGS++)
+//   factr                 Objective-decrease tolerance of L-BFGS-B, in units
+//                         of machine precision; also sets delta of LBFGS++
+//                         for box-constrained problems
+//   max_iterations        Maximum number of iterations
+//   large_nvar            Unconstrained problems with at least large_nvar
+//   large_max_iterations  variables use large_max_iterations instead
+//   max_linesearch        Maximum number of line search trials (LBFGS++)
+//   max_submin            Maximum number of subspace minimizations (LBFGS++)
+//   gtol                  Curvature condition of the line search, GTOL in
+//                         COMMON /LB3/ of lbfgs.f and wolfe of LBFGS++
+//   stpmin, stpmax        Bounds on the line search step, STPMIN and STPMAX
+//                         in COMMON /LB3/, min_step and max_step of LBFGS++
+//   perf                  Hardware counters of the solve (see perf.h): 0-off,
+//                         1-whole solve, 2-also split into oracle and solver
+//   trace                 1 to write a trace of the solve to trace_<solver>.bin
+//                         in the problem directory (see trace.h)
+//   phases                1 to report the time of the phases of the L-BFGS-B
+//                         solvers (Cauchy point, subspace minimization and
+//                         line search) and their active-set statistics
+//   timeline              1 to write a timeline of the setup, evaluations,
+//                         solver steps and teardown to timeline_<solver>.json
+//                         in the problem directory (see timeline.h)
+//   profile               Sampling rate in Hz of a profile of the solve,
+//                         written to profile_<solver>.folded in the problem
+//                         directory (see profile.h), 0 to disable
+// and the options of the repeated timing mode (see timing.h):
+//   repeat_max            Maximum number of timed samples, 0 to disable
+//   repeat_min            Minimum number of samples (default 5)
+//   repeat_warmup         Number of solves before sampling (default 1)
+//   repeat_rel_ci         Target half-width of the confidence interval of
+//                         the median, relative to it (default 0.01)
+//   repeat_batch_time     Minimum time of a batch of solves (default 1e-3)
+//   repeat_max_time       Time budget of the repetitions (default 10)
+class SolverConfig
+{
+private:
+    nlohmann::json m_values;
+
+public:
+    SolverConfig() : m_values(nlohmann::json::object()) {}
+
+    // Set a parameter from its text representation, as given on the
+    // command line. Throws std::invalid_argument on unknown names or
+    // invalid values
+    void set(const std::string& name, const std::string& value);
+    // Set the parameters of a JSON object, with the same checks
+    void merge(const nlohmann::json& values);
+    // Read a JSON object from a file and merge it
+    void merge_file(const std::string& path);
+
+    bool empty() const { return m_values.empty(); }
+    bool has(const std::string& name) const { return m_values.count(name) > 0; }
+    const nlohmann::json& to_json() const { return m_values; }
+
+    // Value of a parameter, or the default given by the caller
+    double get(const std::string& name, double def) const
+    {
+        return has(name) ? m_values[name].get<double>() : def;
+    }
+    int get(const std::string& name, int def) const
+    {
+        return has(name) ? m_values[name].get<int>() : def;
+    }
+};
+
+// Parameters of a configuration set to write files of each solve to the
+// problem directory (trace, timeline and profile)
+std::vector<std::string> file_params(const nlohmann::json& config);
+
+// Parse the command line of run.out and driver.out:
+//   [--solver NAME]... [--config FILE] [--config-json JSON] [--NAME VALUE]... [NAME...]
+// where NAME is a solver ("Classic" or "LBFGS++") and --NAME VALUE sets a
+// parameter of SolverConfig. Throws std::invalid_argument on errors
+void parse_solver_args(const std::vector<std::string>& args,
+                       std::vector<std::string>& solvers, SolverConfig& config);
+
+
+#endif  // CUTEST_PARAM_H
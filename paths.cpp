@@ -0,0 +1,30 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include "paths.h"
+
+// Remove trailing slashes
+static std::string strip_slash(const std::string& path)
+{
+    std::string p = path;
+    while(p.size() > 1 && p[p.size() - 1] == '/')
+        p.erase(p.size() - 1);
+    return p;
+}
+
+std::string path_basename(const std::string& path)
+{
+    const std::string p = strip_slash(path);
+    const std::size_t slash = p.find_last_of('/');
+    return (slash == std::string::npos) ? p : p.substr(slash + 1);
+}
+
+std::string problem_category(const std::string& path)
+{
+    const std::string p = strip_slash(path);
+    const std::size_t slash = p.find_last_of('/');
+    if(slash == std::string::npos)
+        return "";
+    const std::string parent = path_basename(p.substr(0, slash));
+    return (parent == "boxconstr" || parent == "unconstr") ? parent : "";
+}
@@ -0,0 +1,17 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_PATHS_H
+#define CUTEST_PATHS_H
+
+#include <string>
+
+// Last component of a path, ignoring trailing slashes
+std::string path_basename(const std::string& path);
+
+// "boxconstr" or "unconstr", inferred from the parent directory of a
+// problem, or an empty string if it cannot be determined
+std::string problem_category(const std::string& path);
+
+
+#endif  // CUTEST_PATHS_H
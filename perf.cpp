@@ -0,0 +1,130 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <cstring>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "perf.h"
+
+using json = nlohmann::json;
+
+struct PerfEvent
+{
+    const char* name;
+    uint32_t    type;
+    uint64_t    config;
+};
+
+static const PerfEvent perf_events[] = {
+    { "cycles",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "llc_misses",    PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL |
+                                           (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                           (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { "branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES }
+};
+
+static int perf_event_open(perf_event_attr* attr, int group_fd)
+{
+    // This process, any CPU
+    return int(syscall(__NR_perf_event_open, attr, 0, -1, group_fd, 0));
+}
+
+PerfCounters::PerfCounters(bool enable) : m_leader(-1)
+{
+    if(!enable)
+        return;
+
+    const int nevent = sizeof(perf_events) / sizeof(perf_events[0]);
+    for(int i = 0; i < nevent; i++)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = perf_events[i].type;
+        attr.config = perf_events[i].config;
+        attr.disabled = (m_leader < 0) ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+        const int fd = perf_event_open(&attr, m_leader);
+        if(fd < 0)
+            continue;
+        if(m_leader < 0)
+            m_leader = fd;
+        m_fds.push_back(fd);
+        m_events.push_back(i);
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+    for(int fd: m_fds)
+        close(fd);
+}
+
+void PerfCounters::start()
+{
+    if(m_leader >= 0)
+        ioctl(m_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void PerfCounters::stop()
+{
+    if(m_leader >= 0)
+        ioctl(m_leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+}
+
+json PerfCounters::read() const
+{
+    if(m_leader < 0)
+        return json();
+
+    // nr, time_enabled, time_running, then one value per event
+    std::vector<uint64_t> buf(3 + m_fds.size());
+    const ssize_t size = ::read(m_leader, buf.data(), buf.size() * sizeof(uint64_t));
+    if(size < ssize_t(3 * sizeof(uint64_t)) || buf[0] != m_fds.size())
+        return json();
+
+    const double scale = (buf[2] > 0 && buf[2] < buf[1]) ? double(buf[1]) / buf[2] : 1.0;
+    json res = json::object();
+    for(std::size_t i = 0; i < m_fds.size(); i++)
+        res[perf_events[m_events[i]].name] = double(buf[3 + i]) * scale;
+    return res;
+}
+
+// Instructions per cycle, if both are counted
+static void add_ipc(json& counts)
+{
+    if(counts.contains("cycles") && counts.contains("instructions") && counts["cycles"].get<double>() > 0.0)
+        counts["ipc"] = counts["instructions"].get<double>() / counts["cycles"].get<double>();
+}
+
+json perf_to_json(const PerfCounters& solve, const PerfCounters& oracle)
+{
+    json res = solve.read();
+    if(res.is_null())
+        return res;
+
+    const json oracle_counts = oracle.read();
+    if(oracle_counts.is_object())
+    {
+        json solver_counts = json::object();
+        for(json::const_iterator it = res.begin(); it != res.end(); ++it)
+        {
+            if(oracle_counts.contains(it.key()))
+                solver_counts[it.key()] = it.value().get<double>() - oracle_counts[it.key()].get<double>();
+        }
+        json oracle_res = oracle_counts;
+        add_ipc(oracle_res);
+        add_ipc(solver_counts);
+        res["oracle"] = oracle_res;
+        res["solver"] = solver_counts;
+    }
+    add_ipc(res);
+    return res;
+}
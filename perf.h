@@ -0,0 +1,53 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_PERF_H
+#define CUTEST_PERF_H
+
+#include <vector>
+#include "json.hpp"
+
+// Hardware performance counters of the calling process, from
+// perf_event_open(2): cycles, instructions, last-level cache misses and
+// branch misses, user space only
+//
+// The counters form one group that is enabled by start() and disabled by
+// stop(), so the counts accumulate over all start()/stop() intervals.
+// Events that the machine or kernel does not support (e.g. in a VM, or with
+// a restrictive kernel.perf_event_paranoid) are left out, and counts are
+// scaled up if the kernel had to multiplex the counters
+class PerfCounters
+{
+private:
+    int              m_leader;   // File descriptor of the group leader, -1 if none
+    std::vector<int> m_fds;      // File descriptors of the opened events
+    std::vector<int> m_events;   // Index of each opened event in the event table
+
+public:
+    // Counters are only opened if enable is true
+    explicit PerfCounters(bool enable = true);
+    ~PerfCounters();
+
+    // Whether at least one counter could be opened
+    bool available() const { return m_leader >= 0; }
+
+    void start();
+    void stop();
+
+    // Counts as a JSON object, e.g. {"cycles": ..., "instructions": ...},
+    // or null if no counter is available
+    nlohmann::json read() const;
+
+private:
+    PerfCounters(const PerfCounters&);
+    PerfCounters& operator=(const PerfCounters&);
+};
+
+// Counters of a solve for the "perf" field of a record: the counts of the
+// whole solve, and if oracle is available, "oracle" and "solver" objects
+// splitting them into the CUTEst evaluations and the rest. Null if solve
+// is not available
+nlohmann::json perf_to_json(const PerfCounters& solve, const PerfCounters& oracle);
+
+
+#endif  // CUTEST_PERF_H
@@ -0,0 +1,292 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <cctype>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#include <ucontext.h>
+#include <sys/time.h>
+#include "profile.h"
+
+using json = nlohmann::json;
+
+// The profiler that receives SIGPROF
+static Profiler* volatile active_profiler = NULL;
+
+Profiler::Profiler(int hz, int max_samples) :
+    m_hz(hz), m_nsample(0), m_ndropped(0), m_thread(pthread_self()), m_running(false)
+{
+    if(m_hz <= 0)
+        return;
+    m_frames.resize(std::size_t(max_samples) * max_depth);
+    m_depth.resize(max_samples);
+    // The first call of backtrace() loads libgcc, which is not safe in a
+    // signal handler
+    void* dummy[2];
+    backtrace(dummy, 2);
+}
+
+Profiler::~Profiler()
+{
+    stop();
+}
+
+void Profiler::handler(int, siginfo_t*, void* context)
+{
+    Profiler* prof = active_profiler;
+    if(prof == NULL || !pthread_equal(pthread_self(), prof->m_thread))
+        return;
+    const int i = prof->m_nsample;
+    if(i >= int(prof->m_depth.size()))
+    {
+        prof->m_ndropped = prof->m_ndropped + 1;
+        return;
+    }
+
+    const int saved_errno = errno;
+    void** frames = &prof->m_frames[std::size_t(i) * max_depth];
+    int depth = backtrace(frames, max_depth);
+    // Drop the frames of the handler itself, up to the interrupted
+    // instruction if it can be found
+    int skip = std::min(depth, 2);
+#if defined(__x86_64__)
+    void* pc = reinterpret_cast<void*>(static_cast<ucontext_t*>(context)->uc_mcontext.gregs[REG_RIP]);
+    for(int k = 0; k < depth; k++)
+    {
+        if(frames[k] == pc)
+        {
+            skip = k;
+            break;
+        }
+    }
+#else
+    (void) context;
+#endif
+    std::memmove(frames, frames + skip, (depth - skip) * sizeof(void*));
+    prof->m_depth[i] = depth - skip;
+    prof->m_nsample = i + 1;
+    errno = saved_errno;
+}
+
+void Profiler::start()
+{
+    if(m_hz <= 0 || m_running)
+        return;
+    m_thread = pthread_self();
+    active_profiler = this;
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_sigaction = &Profiler::handler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, NULL);
+
+    itimerval timer;
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = std::max(1, 1000000 / m_hz);
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, NULL);
+    m_running = true;
+}
+
+void Profiler::stop()
+{
+    if(!m_running)
+        return;
+    itimerval timer;
+    std::memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, NULL);
+    active_profiler = NULL;
+    signal(SIGPROF, SIG_IGN);
+    m_running = false;
+}
+
+// A symbolized frame
+struct Frame
+{
+    std::string name;     // Function name, or "[library]" if it has no symbol
+    bool        runtime;  // Whether it is in the C, C++ or Fortran runtime
+};
+
+// Shared libraries of the runtimes, whose frames are attributed to their caller
+static const char* runtime_libs[] = {
+    "libc.", "libm.", "libstdc++.", "libgfortran.", "libgcc_s.", "libquadmath.", "libpthread.", "ld-linux"
+};
+
+// Function containing addr, without template arguments and parameters
+static Frame symbolize(void* addr)
+{
+    Frame frame;
+    frame.runtime = false;
+    Dl_info info;
+    if(dladdr(addr, &info) == 0)
+    {
+        frame.name = "[unknown]";
+        return frame;
+    }
+    std::string lib = info.dli_fname ? info.dli_fname : "unknown";
+    const std::size_t slash = lib.find_last_of('/');
+    if(slash != std::string::npos)
+        lib = lib.substr(slash + 1);
+    for(const char* prefix: runtime_libs)
+    {
+        if(lib.compare(0, std::strlen(prefix), prefix) == 0)
+            frame.runtime = true;
+    }
+    if(info.dli_sname == NULL)
+    {
+        frame.name = "[" + lib + "]";
+        return frame;
+    }
+
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+    const std::string full = (status == 0 && demangled) ? demangled : info.dli_sname;
+    std::free(demangled);
+
+    // Remove the text within <...> and (...), and the separators of the
+    // collapsed format
+    int nesting = 0;
+    for(char c: full)
+    {
+        if(c == '<' || c == '(')
+            nesting++;
+        else if(c == '>' || c == ')')
+            nesting = std::max(0, nesting - 1);
+        else if(nesting == 0)
+            frame.name.push_back((c == ';' || c == ' ') ? '_' : c);
+    }
+    if(frame.name.empty())
+        frame.name = full;
+    return frame;
+}
+
+// Routines of the classic solvers, and of the BLAS and LINPACK they use
+static const char* fortran_routines[] = {
+    "setulb_", "mainlb_", "active_", "bmv_", "cauchy_", "cmprlb_", "errclb_", "formk_", "formt_",
+    "freev_", "hpsolb_", "lnsrlb_", "matupd_", "prn1lb_", "prn2lb_", "prn3lb_", "projgr_", "subsm_",
+    "dcsrch_", "dcstep_", "timer_", "lbfgs_", "lb1_", "mcsrch_", "mcstep_"
+};
+static const char* blas_routines[] = {
+    "dnrm2_", "daxpy_", "dcopy_", "ddot_", "dscal_", "dpofa_", "dtrsl_"
+};
+
+static bool in_list(const std::string& name, const char* const* list, std::size_t n)
+{
+    for(std::size_t i = 0; i < n; i++)
+    {
+        if(name == list[i])
+            return true;
+    }
+    return false;
+}
+
+static bool starts_with(const std::string& str, const char* prefix)
+{
+    return str.compare(0, std::strlen(prefix), prefix) == 0;
+}
+
+json Profiler::write_folded(const std::string& path) const
+{
+    if(m_hz <= 0)
+        return json();
+
+    // Symbolize each distinct address once; return addresses point after
+    // the call, so the caller frames are looked up one byte before
+    std::map<void*, Frame> symbols;
+    auto frame_of = [&symbols](void* addr) -> const Frame& {
+        auto it = symbols.find(addr);
+        if(it == symbols.end())
+            it = symbols.insert(std::make_pair(addr, symbolize(addr))).first;
+        return it->second;
+    };
+
+    std::map<std::string, long> stacks;
+    long problem = 0, cutest = 0, lbfgspp = 0, eigen = 0, glue = 0;
+    std::map<std::string, long> fortran;
+    const std::size_t nfortran = sizeof(fortran_routines) / sizeof(fortran_routines[0]);
+    const std::size_t nblas = sizeof(blas_routines) / sizeof(blas_routines[0]);
+    for(int i = 0; i < m_nsample; i++)
+    {
+        void* const* frames = &m_frames[std::size_t(i) * max_depth];
+        const int depth = m_depth[i];
+        if(depth <= 0)
+            continue;
+        std::vector<std::string> stack(depth);
+        int inner = -1;
+        for(int k = 0; k < depth; k++)
+        {
+            void* addr = (k == 0) ? frames[k] : static_cast<void*>(static_cast<char*>(frames[k]) - 1);
+            const Frame& frame = frame_of(addr);
+            stack[k] = frame.name;
+            if(inner < 0 && !frame.runtime)
+                inner = k;
+        }
+
+        // Attribution by the innermost frame outside the runtimes (e.g. sin()
+        // called by ELFUN), where BLAS and LINPACK count for the solver
+        // routine that called them
+        const std::string& leaf = stack[inner < 0 ? 0 : inner];
+        std::string lower = leaf;
+        for(char& c: lower)
+            c = std::tolower(static_cast<unsigned char>(c));
+        if(starts_with(lower, "elfun") || starts_with(lower, "group") || starts_with(lower, "range"))
+        {
+            problem++;
+        } else if(lower.find("cutest") != std::string::npos ||
+                  (starts_with(lower, "__") && lower.find("_mod_") != std::string::npos)) {
+            cutest++;
+        } else if(in_list(lower, fortran_routines, nfortran) || in_list(lower, blas_routines, nblas)) {
+            std::string routine = lower;
+            for(int k = inner; k < depth && in_list(routine, blas_routines, nblas); k++)
+            {
+                std::string caller = stack[k];
+                for(char& c: caller)
+                    c = std::tolower(static_cast<unsigned char>(c));
+                if(in_list(caller, fortran_routines, nfortran))
+                    routine = caller;
+            }
+            // Without the trailing underscore of gfortran
+            fortran[routine.substr(0, routine.size() - 1)]++;
+        } else if(starts_with(leaf, "LBFGSpp::")) {
+            lbfgspp++;
+        } else if(starts_with(leaf, "Eigen::")) {
+            eigen++;
+        } else {
+            glue++;
+        }
+
+        std::string line;
+        for(int k = depth - 1; k >= 0; k--)
+        {
+            line += stack[k];
+            if(k > 0)
+                line += ';';
+        }
+        stacks[line]++;
+    }
+
+    std::ofstream out(path);
+    for(const auto& stack: stacks)
+        out << stack.first << ' ' << stack.second << '\n';
+
+    return json{
+        { "hz", m_hz },
+        { "samples", int(m_nsample) },
+        { "dropped", int(m_ndropped) },
+        { "problem", problem },
+        { "cutest", cutest },
+        { "fortran", fortran },
+        { "lbfgspp", lbfgspp },
+        { "eigen", eigen },
+        { "glue", glue }
+    };
+}
@@ -0,0 +1,71 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_PROFILE_H
+#define CUTEST_PROFILE_H
+
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <signal.h>
+#include "json.hpp"
+
+// Sampling profiler of the calling thread, driven by SIGPROF
+//
+// While started, the CPU time of the process triggers SIGPROF at the given
+// rate, and the handler records the call stack of the thread that started
+// the profiler with backtrace(3). The samples go to a buffer allocated in
+// advance, and samples beyond its capacity are dropped. Stacks are only
+// symbolized by write_folded(), with dladdr(3): functions of the program
+// itself need the -rdynamic link flag to be named, and template arguments
+// and parameter lists are removed from C++ names to keep them readable
+//
+// Only one profiler can be active at a time
+class Profiler
+{
+private:
+    int                m_hz;
+    std::vector<void*> m_frames;    // max_samples blocks of max_depth frames
+    std::vector<int>   m_depth;     // Number of frames of each sample
+    volatile int       m_nsample;
+    volatile int       m_ndropped;
+    pthread_t          m_thread;
+    bool               m_running;
+
+    static void handler(int sig, siginfo_t* info, void* context);
+
+public:
+    static const int max_depth = 32;
+
+    // Sample hz times per second of CPU time, keeping at most max_samples
+    // samples. Nothing is done if hz <= 0
+    explicit Profiler(int hz, int max_samples = 1 << 15);
+    ~Profiler();
+
+    bool enabled() const { return m_hz > 0; }
+
+    void start();
+    void stop();
+
+    // Write the samples to path as collapsed stacks, one line per distinct
+    // stack: "root;...;leaf count", which flamegraph.out turns into a flame
+    // graph. Returns null if the profiler is not enabled, and otherwise the
+    // numbers of samples ("hz", "samples", "dropped") and their attribution,
+    // by the innermost frame outside the C, C++ and Fortran runtimes, to:
+    //   problem  ELFUN, GROUP and RANGE of the problem
+    //   cutest   The rest of CUTEst
+    //   fortran  The classic solvers, as an object with one count per
+    //            routine of lbfgs.f and lbfgsb.f (e.g. cauchy, formk, subsm,
+    //            bmv); the BLAS and LINPACK routines count for their caller
+    //   lbfgspp  LBFGS++, including the Eigen code inlined in it
+    //   eigen    Eigen functions that were not inlined
+    //   glue     Everything else: the interface, runtimes, unknown frames
+    nlohmann::json write_folded(const std::string& path) const;
+
+private:
+    Profiler(const Profiler&);
+    Profiler& operator=(const Profiler&);
+};
+
+
+#endif  // CUTEST_PROFILE_H
@@ -0,0 +1,61 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <sys/mman.h>
+#include "progress.h"
+
+CUTEstProgress* cutest_progress = NULL;
+
+// Map the shared progress record, if the runner provided one
+static void progress_attach()
+{
+    static bool attached = false;
+    if(attached)
+        return;
+    attached = true;
+
+    const char* env = std::getenv("CUTEST_PROGRESS_FD");
+    if(env == NULL)
+        return;
+    void* addr = mmap(NULL, sizeof(CUTEstProgress), PROT_READ | PROT_WRITE,
+                      MAP_SHARED, std::atoi(env), 0);
+    if(addr != MAP_FAILED)
+        cutest_progress = static_cast<CUTEstProgress*>(addr);
+}
+
+// Copy a name with a terminating zero
+static void copy_name(char* dest, const char* src)
+{
+    std::strncpy(dest, src, 15);
+    dest[15] = '\0';
+}
+
+void progress_start(const char* alg, const char* solver, const char* prob, int nvar)
+{
+    progress_attach();
+    if(!cutest_progress)
+        return;
+
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    copy_name(cutest_progress->prob, prob);
+    copy_name(cutest_progress->alg, alg);
+    copy_name(cutest_progress->solver, solver);
+    cutest_progress->nvar = nvar;
+    cutest_progress->niter = 0;
+    cutest_progress->nfun = 0;
+    cutest_progress->objval = std::numeric_limits<double>::quiet_NaN();
+    cutest_progress->start_time = ts.tv_sec + 1e-9 * ts.tv_nsec;
+    cutest_progress->active = 1;
+}
+
+void progress_finish()
+{
+    if(cutest_progress)
+        cutest_progress->active = 0;
+}
@@ -0,0 +1,50 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_PROGRESS_H
+#define CUTEST_PROGRESS_H
+
+// Live progress of the solve that is currently running
+//
+// When run.out is started by run_suite.out, this record lives in a file
+// shared with the runner (passed through the CUTEST_PROGRESS_FD environment
+// variable), so the runner can still report the iteration and evaluation
+// counts if it has to kill the process
+struct CUTEstProgress
+{
+    char   prob[16];         // Problem name
+    char   alg[16];          // Algorithm, e.g. "L-BFGS-B"
+    char   solver[16];       // Solver, e.g. "Classic"
+    int    active;           // 1 while a solve is in progress
+    int    nvar;             // Number of variables
+    int    niter;            // Number of iterations so far
+    int    nfun;             // Number of function evaluations so far
+    double objval;           // Last objective function value
+    double start_time;       // CLOCK_MONOTONIC time when the solve started
+};
+
+// NULL if the program is not run under run_suite.out
+extern CUTEstProgress* cutest_progress;
+
+// Called by the interfaces once the problem is set up
+void progress_start(const char* alg, const char* solver, const char* prob, int nvar);
+// Called when the solve is finished, whether or not it succeeded
+void progress_finish();
+
+inline void progress_iter(int niter)
+{
+    if(cutest_progress)
+        cutest_progress->niter = niter;
+}
+
+inline void progress_eval(double fx)
+{
+    if(cutest_progress)
+    {
+        cutest_progress->nfun++;
+        cutest_progress->objval = fx;
+    }
+}
+
+
+#endif  // CUTEST_PROGRESS_H
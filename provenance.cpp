@@ -0,0 +1,113 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <string>
+#include <fstream>
+#include <ctime>
+#include <unistd.h>
+#include <Eigen/Core>
+#include "provenance.h"
+
+// Build information passed by the Makefile
+#ifndef BUILD_CXXFLAGS
+#define BUILD_CXXFLAGS ""
+#endif
+#ifndef BUILD_FC
+#define BUILD_FC ""
+#endif
+#ifndef BUILD_FCFLAGS
+#define BUILD_FCFLAGS ""
+#endif
+#ifndef BUILD_LBFGSPP
+#define BUILD_LBFGSPP ""
+#endif
+#ifndef BUILD_CUTEST
+#define BUILD_CUTEST ""
+#endif
+#ifndef BUILD_MYARCH
+#define BUILD_MYARCH ""
+#endif
+#ifndef BUILD_CUTEST_COMMIT
+#define BUILD_CUTEST_COMMIT ""
+#endif
+
+#define STRINGIFY_(x) #x
+#define STRINGIFY(x) STRINGIFY_(x)
+
+using json = nlohmann::json;
+
+// Value of the first "key : value" line of a file starting with key
+static std::string read_field(const char* path, const std::string& key)
+{
+    std::ifstream file(path);
+    std::string line;
+    while(std::getline(file, line))
+    {
+        if(line.compare(0, key.size(), key) != 0)
+            continue;
+        std::string::size_type pos = line.find(':');
+        if(pos == std::string::npos)
+            continue;
+        pos = line.find_first_not_of(" \t", pos + 1);
+        return (pos == std::string::npos) ? std::string() : line.substr(pos);
+    }
+    return std::string();
+}
+
+static std::string read_line(const char* path)
+{
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+// Fields that do not change during a run
+static json static_provenance()
+{
+    char host[256] = "";
+    if(gethostname(host, sizeof(host)) != 0)
+        host[0] = '\0';
+    host[sizeof(host) - 1] = '\0';
+
+#if defined(__clang__)
+    const std::string compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    const std::string compiler = "gcc " __VERSION__;
+#else
+    const std::string compiler = "";
+#endif
+
+    return json{
+        {"cpu", read_field("/proc/cpuinfo", "model name")},
+        {"governor", read_line("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor")},
+        {"hostname", host},
+        {"compiler", compiler},
+        {"cxxflags", BUILD_CXXFLAGS},
+        {"fc", BUILD_FC},
+        {"fcflags", BUILD_FCFLAGS},
+        {"eigen", STRINGIFY(EIGEN_WORLD_VERSION) "." STRINGIFY(EIGEN_MAJOR_VERSION) "." STRINGIFY(EIGEN_MINOR_VERSION)},
+        {"lbfgspp", BUILD_LBFGSPP},
+        {"cutest", {
+            {"dir", BUILD_CUTEST},
+            {"arch", BUILD_MYARCH},
+            {"commit", BUILD_CUTEST_COMMIT}
+        }}
+    };
+}
+
+json run_provenance()
+{
+    // Initialized once, also with concurrent callers
+    static const json fixed = static_provenance();
+
+    const std::time_t now = std::time(NULL);
+    std::tm tm;
+    char stamp[32] = "";
+    if(gmtime_r(&now, &tm) != NULL)
+        std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", &tm);
+
+    json env = fixed;
+    env["timestamp"] = stamp;
+    return env;
+}
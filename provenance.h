@@ -0,0 +1,28 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_PROVENANCE_H
+#define CUTEST_PROVENANCE_H
+
+#include "json.hpp"
+
+// Where and how a record was produced, added to every record as "env" so
+// that results of different machines and builds can be told apart:
+//   cpu        Model name of the CPU, from /proc/cpuinfo
+//   governor   Frequency governor of CPU 0 ("" if there is no cpufreq)
+//   hostname   Name of the machine
+//   timestamp  Time of the record, ISO 8601 in UTC
+//   compiler   Version of the C++ compiler
+//   cxxflags   CXXFLAGS and the -D macros of CPPFLAGS of the build
+//   fc         Version of the Fortran compiler
+//   fcflags    FCFLAGS of the build
+//   eigen      Version of Eigen
+//   lbfgspp    Commit of LBFGS++ downloaded by `make headers`
+//   cutest     Directory, architecture and git commit of the CUTEst build
+//
+// The build fields are compiled into provenance.o by the Makefile, and are
+// "" when they are not defined
+nlohmann::json run_provenance();
+
+
+#endif  // CUTEST_PROVENANCE_H
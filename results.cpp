@@ -0,0 +1,157 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cmath>
+#include <limits>
+#include "results.h"
+
+using json = nlohmann::json;
+
+// Replace the non-finite numbers of a value, which dump() would turn into
+// null, by strings
+static void encode_nonfinite(json& value)
+{
+    if(value.is_structured())
+    {
+        for(json& elem: value)
+            encode_nonfinite(elem);
+    } else if(value.is_number_float()) {
+        const double x = value.get<double>();
+        if(std::isnan(x))
+            value = "NaN";
+        else if(std::isinf(x))
+            value = (x > 0) ? "Inf" : "-Inf";
+    }
+}
+
+std::string record_line(const json& rec)
+{
+    json copy = rec;
+    encode_nonfinite(copy);
+    return copy.dump();
+}
+
+void write_record(std::ostream& out, const json& rec)
+{
+    out << record_line(rec) << std::endl;
+}
+
+double record_number(const json& value)
+{
+    if(value.is_number())
+        return value.get<double>();
+    if(value.is_string())
+    {
+        const std::string& str = value.get_ref<const std::string&>();
+        if(str == "Inf")
+            return std::numeric_limits<double>::infinity();
+        if(str == "-Inf")
+            return -std::numeric_limits<double>::infinity();
+    }
+    return std::numeric_limits<double>::quiet_NaN();
+}
+
+// Replace the null values of a record of an older log by "NaN"
+static void decode_null(json& value)
+{
+    if(value.is_structured())
+    {
+        for(json& elem: value)
+            decode_null(elem);
+    } else if(value.is_null()) {
+        value = "NaN";
+    }
+}
+
+bool upgrade_record(json& rec)
+{
+    if(rec.contains("schema"))
+    {
+        const json& schema = rec["schema"];
+        if(!schema.is_number_integer() || schema.get<int>() > record_schema)
+            throw std::runtime_error("unsupported record schema " + schema.dump());
+        return false;
+    }
+    decode_null(rec);
+    rec["schema"] = record_schema;
+    return true;
+}
+
+// Net change of brace depth in a line, ignoring braces inside strings
+static int brace_balance(const std::string& line)
+{
+    int depth = 0;
+    bool in_string = false;
+    for(std::size_t i = 0; i < line.size(); i++)
+    {
+        const char c = line[i];
+        if(in_string)
+        {
+            if(c == '\\')
+                i++;
+            else if(c == '"')
+                in_string = false;
+        } else if(c == '"') {
+            in_string = true;
+        } else if(c == '{') {
+            depth++;
+        } else if(c == '}') {
+            depth--;
+        }
+    }
+    return depth;
+}
+
+void read_records(std::istream& in, const std::function<void(json&)>& fn)
+{
+    std::string line, buffer;
+    int depth = 0;
+    while(std::getline(in, line))
+    {
+        // A record always starts at the beginning of a line
+        if(depth == 0 && (line.empty() || line[0] != '{'))
+            continue;
+
+        buffer += line;
+        buffer += '\n';
+        depth += brace_balance(line);
+        if(depth > 0)
+            continue;
+
+        // A complete object has been collected
+        try {
+            json rec = json::parse(buffer);
+            if(rec.is_object())
+                fn(rec);
+        } catch (json::exception&) {
+            // Garbled output, e.g. a Fortran message written in the middle
+            // of a record; skip it
+        }
+        buffer.clear();
+        depth = 0;
+    }
+}
+
+std::vector<json> read_records(std::istream& in)
+{
+    std::vector<json> records;
+    read_records(in, [&records](json& rec) { records.push_back(std::move(rec)); });
+    return records;
+}
+
+std::vector<json> parse_records(const std::string& text)
+{
+    std::istringstream in(text);
+    return read_records(in);
+}
+
+std::vector<json> read_records_file(const std::string& path)
+{
+    std::ifstream in(path);
+    if(!in)
+        throw std::runtime_error("cannot open file " + path);
+    return read_records(in);
+}
@@ -0,0 +1,55 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_RESULTS_H
+#define CUTEST_RESULTS_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include "json.hpp"
+
+// Version of the record layout, stored as "schema" in every record
+//
+//   1  JSON Lines: one compact object per line, written as soon as the
+//      solve finishes. Non-finite numbers are the strings "Inf", "-Inf"
+//      and "NaN", as read by jsonlite
+//
+// Records without "schema" come from older logs: pretty-printed objects
+// mixed with other output, where non-finite numbers were written as null
+const int record_schema = 1;
+
+// A record as one line of JSON, without the newline, with the non-finite
+// numbers encoded as strings
+std::string record_line(const nlohmann::json& rec);
+// Write a record line to out and flush it, so that the log can be followed
+// while it is written
+void write_record(std::ostream& out, const nlohmann::json& rec);
+
+// Value of a numeric field of a record, decoding "Inf", "-Inf" and "NaN";
+// NaN if the value is neither a number nor one of these strings (e.g. the
+// null of an older log)
+double record_number(const nlohmann::json& value);
+
+// Bring a record of an older log to the current schema: its null values,
+// which were all non-finite numbers, become "NaN" since their sign is lost,
+// and "schema" is set. Returns true if the record was changed, and throws
+// std::runtime_error if it has a schema newer than record_schema
+bool upgrade_record(nlohmann::json& rec);
+
+// Extract the JSON objects printed by run.out from a text stream
+// Other output, such as messages from the Fortran code and "# Run ..."
+// comments of older logs, is skipped. Both compact (one object per line)
+// and pretty-printed (dump(2)) records are recognized
+std::vector<nlohmann::json> parse_records(const std::string& text);
+std::vector<nlohmann::json> read_records(std::istream& in);
+// Same as above, passing each record to fn as it is read instead of
+// keeping them, so that logs of any size are read in constant memory
+void read_records(std::istream& in, const std::function<void(nlohmann::json&)>& fn);
+
+// Read records from a log file, throwing std::runtime_error on failure
+std::vector<nlohmann::json> read_records_file(const std::string& path);
+
+
+#endif  // CUTEST_RESULTS_H
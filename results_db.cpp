@@ -0,0 +1,156 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <cmath>
+#include <ctime>
+#include <stdexcept>
+#include <sys/stat.h>
+#include "resultsdb.h"
+#include "results.h"
+#include "paths.h"
+
+// Import logs into a results database (see resultsdb.h) and query it
+//
+// Each imported log is one run, labelled by the file name unless -l is
+// given. Its start time is the timestamp of the first record, or the date
+// in the file name (e.g. run_20230503.log), or the modification time of the
+// file. Queries print a tab-separated table with a header, with NA for NULL
+
+void print_usage()
+{
+    std::cerr << "Usage: results_db.out import [-l label] DB LOG..." << std::endl;
+    std::cerr << "       results_db.out query DB SQL" << std::endl;
+    std::cerr << "  import       Add each LOG (JSON Lines, or an older pretty-printed log) as a run" << std::endl;
+    std::cerr << "  -l label     Label of the imported runs (default: the name of each log)" << std::endl;
+    std::cerr << "  query        Run SQL and print the rows, e.g. on the tables runs and results," << std::endl;
+    std::cerr << "               the view solver_pairs and the aggregate median()" << std::endl;
+}
+
+// Start time of the run of a log
+static std::string log_started(const std::string& path, const std::vector<nlohmann::json>& records)
+{
+    if(!records.empty())
+    {
+        const auto env = records[0].find("env");
+        if(env != records[0].end() && env->is_object() && env->contains("timestamp"))
+        {
+            const nlohmann::json& stamp = (*env)["timestamp"];
+            if(stamp.is_string() && !stamp.get<std::string>().empty())
+                return stamp.get<std::string>();
+        }
+    }
+
+    // YYYYMMDD in the file name
+    const std::string name = path_basename(path);
+    for(std::size_t i = 0; i + 8 <= name.size(); i++)
+    {
+        std::size_t n = 0;
+        while(n < 8 && std::isdigit(static_cast<unsigned char>(name[i + n])))
+            n++;
+        const bool bounded = (i == 0 || !std::isdigit(static_cast<unsigned char>(name[i - 1]))) &&
+                             (i + 8 == name.size() || !std::isdigit(static_cast<unsigned char>(name[i + 8])));
+        if(n == 8 && bounded && name.compare(i, 2, "19") >= 0 && name.compare(i, 2, "21") < 0)
+            return name.substr(i, 4) + "-" + name.substr(i + 4, 2) + "-" + name.substr(i + 6, 2) + "T00:00:00Z";
+    }
+
+    struct stat st;
+    char stamp[32] = "";
+    std::tm tm;
+    if(stat(path.c_str(), &st) == 0 && gmtime_r(&st.st_mtime, &tm) != NULL)
+        std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", &tm);
+    return stamp;
+}
+
+static std::string format_value(const nlohmann::json& value)
+{
+    if(value.is_null())
+        return "NA";
+    if(value.is_string())
+        return value.get<std::string>();
+    if(value.is_number_float())
+    {
+        const double x = value.get<double>();
+        if(std::isinf(x))
+            return (x > 0) ? "Inf" : "-Inf";
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.10g", x);
+        return buf;
+    }
+    return value.dump();
+}
+
+int main(int argc, char* argv[])
+{
+    using json = nlohmann::json;
+
+    if(argc < 2)
+    {
+        print_usage();
+        return 1;
+    }
+
+    try {
+        if(std::strcmp(argv[1], "import") == 0)
+        {
+            std::string label;
+            std::vector<std::string> args;
+            for(int i = 2; i < argc; i++)
+            {
+                if(std::strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+                {
+                    label = argv[++i];
+                } else if(argv[i][0] == '-') {
+                    print_usage();
+                    return 1;
+                } else {
+                    args.push_back(argv[i]);
+                }
+            }
+            if(args.size() < 2)
+            {
+                print_usage();
+                return 1;
+            }
+
+            ResultsDB db(args[0]);
+            for(std::size_t i = 1; i < args.size(); i++)
+            {
+                const std::string& log = args[i];
+                const std::vector<json> records = read_records_file(log);
+                const long long run = db.add_run(label.empty() ? path_basename(log) : label,
+                                                 log, log_started(log, records));
+                // One transaction per log
+                const int nadded = db.add(run, records);
+                std::cerr << "# " << log << ": run " << run << ", " << nadded << " records" << std::endl;
+            }
+        } else if(std::strcmp(argv[1], "query") == 0 && argc == 4) {
+            ResultsDB db(argv[2]);
+            std::vector<std::string> header;
+            db.query(argv[3], [&header](const std::vector<std::string>& names, const json& values) {
+                if(names != header)
+                {
+                    for(std::size_t i = 0; i < names.size(); i++)
+                        std::cout << (i ? "\t" : "") << names[i];
+                    std::cout << '\n';
+                    header = names;
+                }
+                for(std::size_t i = 0; i < values.size(); i++)
+                    std::cout << (i ? "\t" : "") << format_value(values[i]);
+                std::cout << '\n';
+            });
+            std::cout.flush();
+        } else {
+            print_usage();
+            return 1;
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,363 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <cmath>
+#include <ctime>
+#include <stdexcept>
+#include <algorithm>
+#include <sqlite3.h>
+#include "resultsdb.h"
+#include "results.h"
+#include "sha256.h"
+
+using json = nlohmann::json;
+
+// Version of the database layout, stored in PRAGMA user_version
+static const int db_version = 1;
+
+// Columns of the table results taken from the records: field of the record,
+// or timing.<field> for timing_<field>
+struct ResultColumn
+{
+    const char* name;
+    const char* type;
+};
+
+static const ResultColumn result_columns[] = {
+    { "flag",            "INTEGER" },
+    { "msg",             "TEXT"    },
+    { "nvar",            "INTEGER" },
+    { "niter",           "INTEGER" },
+    { "nfun",            "INTEGER" },
+    { "ngrad",           "INTEGER" },
+    { "nhess",           "INTEGER" },
+    { "nhprod",          "INTEGER" },
+    { "objval",          "REAL"    },
+    { "proj_grad",       "REAL"    },
+    { "setup_time",      "REAL"    },
+    { "solve_time",      "REAL"    },
+    { "oracle_wall",     "REAL"    },
+    { "oracle_cpu",      "REAL"    },
+    { "solver_wall",     "REAL"    },
+    { "solver_cpu",      "REAL"    },
+    { "workspace",       "INTEGER" },
+    { "peak_rss",        "INTEGER" },
+    { "minor_faults",    "INTEGER" },
+    { "major_faults",    "INTEGER" },
+    { "timing_nrep",     "INTEGER" },
+    { "timing_batch",    "INTEGER" },
+    { "timing_warmup",   "INTEGER" },
+    { "timing_min",      "REAL"    },
+    { "timing_median",   "REAL"    },
+    { "timing_mad",      "REAL"    },
+    { "timing_ci_lower", "REAL"    },
+    { "timing_ci_upper", "REAL"    }
+};
+static const int nresult_column = sizeof(result_columns) / sizeof(result_columns[0]);
+
+// Key columns, bound before result_columns, and the whole record after them
+static const int nkey_column = 6;
+
+// Current time in ISO 8601, UTC
+static std::string utc_now()
+{
+    const std::time_t now = std::time(NULL);
+    std::tm tm;
+    char stamp[32] = "";
+    if(gmtime_r(&now, &tm) != NULL)
+        std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", &tm);
+    return stamp;
+}
+
+// Aggregate median(x), ignoring NULL
+static void median_step(sqlite3_context* ctx, int, sqlite3_value** argv)
+{
+    if(sqlite3_value_type(argv[0]) == SQLITE_NULL)
+        return;
+    std::vector<double>** values = static_cast<std::vector<double>**>(
+        sqlite3_aggregate_context(ctx, sizeof(std::vector<double>*)));
+    if(values == NULL)
+    {
+        sqlite3_result_error_nomem(ctx);
+        return;
+    }
+    if(*values == NULL)
+        *values = new std::vector<double>();
+    (*values)->push_back(sqlite3_value_double(argv[0]));
+}
+
+static void median_final(sqlite3_context* ctx)
+{
+    std::vector<double>** values = static_cast<std::vector<double>**>(
+        sqlite3_aggregate_context(ctx, 0));
+    if(values == NULL || *values == NULL)
+    {
+        sqlite3_result_null(ctx);
+        return;
+    }
+    std::vector<double>& x = **values;
+    const std::size_t mid = x.size() / 2;
+    std::nth_element(x.begin(), x.begin() + mid, x.end());
+    double med = x[mid];
+    if(x.size() % 2 == 0)
+        med = 0.5 * (med + *std::max_element(x.begin(), x.begin() + mid));
+    sqlite3_result_double(ctx, med);
+    delete *values;
+    *values = NULL;
+}
+
+ResultsDB::ResultsDB(const std::string& path) :
+    m_db(NULL), m_insert(NULL)
+{
+    const int rc = sqlite3_open(path.c_str(), &m_db);
+    if(rc != SQLITE_OK)
+    {
+        const std::string msg = m_db ? sqlite3_errmsg(m_db) : "out of memory";
+        sqlite3_close(m_db);
+        m_db = NULL;
+        throw std::runtime_error(path + ": " + msg);
+    }
+
+    try {
+        sqlite3_busy_timeout(m_db, 60000);
+        check(sqlite3_create_function(m_db, "median", 1, SQLITE_UTF8, NULL,
+                                      NULL, median_step, median_final), "median()");
+
+        // Check the version before changing anything
+        int version = 0;
+        query("PRAGMA user_version", [&version](const std::vector<std::string>&, const json& values) {
+            version = values[0].get<int>();
+        });
+        if(version > db_version)
+            throw std::runtime_error("version " + std::to_string(version) + " of the database is not supported");
+
+        exec("PRAGMA journal_mode = WAL");
+        std::string columns;
+        for(const ResultColumn& col: result_columns)
+            columns += std::string("    ") + col.name + " " + col.type + ",\n";
+        exec("BEGIN");
+        exec(
+            "CREATE TABLE IF NOT EXISTS runs (\n"
+            "    id INTEGER PRIMARY KEY,\n"
+            "    label TEXT,\n"
+            "    started TEXT NOT NULL,\n"
+            "    source TEXT\n"
+            ");\n"
+            "CREATE TABLE IF NOT EXISTS results (\n"
+            "    run_id INTEGER NOT NULL REFERENCES runs(id),\n"
+            "    problem TEXT,\n"
+            "    alg TEXT NOT NULL,\n"
+            "    solver TEXT NOT NULL,\n"
+            "    config_hash TEXT NOT NULL,\n"
+            "    config TEXT NOT NULL,\n" +
+            columns +
+            "    record TEXT NOT NULL,\n"
+            "    PRIMARY KEY (run_id, problem, alg, solver, config_hash)\n"
+            ");\n"
+            "CREATE INDEX IF NOT EXISTS results_problem ON results (problem, alg, solver);\n"
+            "CREATE INDEX IF NOT EXISTS results_nvar ON results (nvar);\n"
+            "CREATE INDEX IF NOT EXISTS runs_started ON runs (started);\n"
+            "CREATE VIEW IF NOT EXISTS solver_pairs AS\n"
+            "SELECT c.run_id, c.problem, c.alg, c.config_hash, c.nvar,\n"
+            "       c.flag AS classic_flag, l.flag AS lbfgspp_flag,\n"
+            "       c.niter AS classic_niter, l.niter AS lbfgspp_niter,\n"
+            "       c.nfun AS classic_nfun, l.nfun AS lbfgspp_nfun,\n"
+            "       c.objval AS classic_objval, l.objval AS lbfgspp_objval,\n"
+            "       c.solve_time AS classic_time, l.solve_time AS lbfgspp_time\n"
+            "FROM results c JOIN results l\n"
+            "  ON c.run_id = l.run_id AND c.problem = l.problem AND\n"
+            "     c.alg = l.alg AND c.config_hash = l.config_hash\n"
+            "WHERE c.solver = 'Classic' AND l.solver = 'LBFGS++';\n"
+            "PRAGMA user_version = " + std::to_string(db_version) + ";\n"
+        );
+        exec("COMMIT");
+
+        std::string sql = "INSERT INTO results (run_id, problem, alg, solver, config_hash, config";
+        for(const ResultColumn& col: result_columns)
+            sql += std::string(", ") + col.name;
+        sql += ", record) VALUES (?";
+        for(int i = 1; i < nkey_column + nresult_column + 1; i++)
+            sql += ", ?";
+        sql += ")";
+        check(sqlite3_prepare_v2(m_db, sql.c_str(), -1, &m_insert, NULL), "preparing insertion");
+    } catch (...) {
+        sqlite3_finalize(m_insert);
+        sqlite3_close(m_db);
+        throw;
+    }
+}
+
+ResultsDB::~ResultsDB()
+{
+    sqlite3_finalize(m_insert);
+    sqlite3_close(m_db);
+}
+
+void ResultsDB::check(int rc, const std::string& what) const
+{
+    if(rc != SQLITE_OK && rc != SQLITE_ROW && rc != SQLITE_DONE)
+        throw std::runtime_error(what + ": " + sqlite3_errmsg(m_db));
+}
+
+void ResultsDB::exec(const std::string& sql)
+{
+    char* err = NULL;
+    if(sqlite3_exec(m_db, sql.c_str(), NULL, NULL, &err) != SQLITE_OK)
+    {
+        const std::string msg = err ? err : sqlite3_errmsg(m_db);
+        sqlite3_free(err);
+        throw std::runtime_error(msg);
+    }
+}
+
+long long ResultsDB::add_run(const std::string& label, const std::string& source,
+                             const std::string& started)
+{
+    sqlite3_stmt* stmt = NULL;
+    check(sqlite3_prepare_v2(m_db, "INSERT INTO runs (label, started, source) VALUES (?, ?, ?)",
+                             -1, &stmt, NULL), "adding run");
+    const std::string time = started.empty() ? utc_now() : started;
+    sqlite3_bind_text(stmt, 1, label.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, time.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 3, source.c_str(), -1, SQLITE_TRANSIENT);
+    const int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    check(rc, "adding run");
+    return sqlite3_last_insert_rowid(m_db);
+}
+
+// Bind a field of a record to a parameter of the given column type
+static void bind_field(sqlite3_stmt* stmt, int index, const std::string& type, const json* value)
+{
+    if(value == NULL || value->is_null())
+    {
+        sqlite3_bind_null(stmt, index);
+    } else if(type == "TEXT") {
+        const std::string str = value->is_string() ? value->get<std::string>() : value->dump();
+        sqlite3_bind_text(stmt, index, str.c_str(), -1, SQLITE_TRANSIENT);
+    } else if(type == "INTEGER" && value->is_number_integer()) {
+        sqlite3_bind_int64(stmt, index, value->get<sqlite3_int64>());
+    } else {
+        // Non-finite numbers are encoded as strings, NaN is stored as NULL
+        const double x = record_number(*value);
+        if(std::isnan(x))
+            sqlite3_bind_null(stmt, index);
+        else
+            sqlite3_bind_double(stmt, index, x);
+    }
+}
+
+int ResultsDB::add(long long run, const std::vector<json>& records)
+{
+    int nadded = 0;
+    exec("BEGIN IMMEDIATE");
+    try {
+        for(const json& rec: records)
+        {
+            const json config = rec.contains("config") ? rec["config"] : json::object();
+            const std::string key[] = {
+                rec.value("problem", std::string()),
+                rec.value("alg", std::string()),
+                rec.value("solver", std::string()),
+                config_hash(config),
+                config.dump()
+            };
+            sqlite3_reset(m_insert);
+            sqlite3_clear_bindings(m_insert);
+            sqlite3_bind_int64(m_insert, 1, run);
+            // Records of older logs may have no problem name, see resultsdb.h
+            for(int i = 0; i < nkey_column - 1; i++)
+            {
+                if(i == 0 && key[i].empty())
+                    sqlite3_bind_null(m_insert, i + 2);
+                else
+                    sqlite3_bind_text(m_insert, i + 2, key[i].c_str(), -1, SQLITE_TRANSIENT);
+            }
+            for(int i = 0; i < nresult_column; i++)
+            {
+                const std::string name = result_columns[i].name;
+                const json* value = NULL;
+                if(name.compare(0, 7, "timing_") == 0)
+                {
+                    const auto timing = rec.find("timing");
+                    if(timing != rec.end() && timing->is_object())
+                    {
+                        const auto it = timing->find(name.substr(7));
+                        if(it != timing->end())
+                            value = &*it;
+                    }
+                } else {
+                    const auto it = rec.find(name);
+                    if(it != rec.end())
+                        value = &*it;
+                }
+                bind_field(m_insert, nkey_column + i + 1, result_columns[i].type, value);
+            }
+            const std::string line = record_line(rec);
+            sqlite3_bind_text(m_insert, nkey_column + nresult_column + 1, line.c_str(), -1, SQLITE_TRANSIENT);
+            check(sqlite3_step(m_insert), "adding record " + key[0] + " " + key[1] + " " + key[2] + " " + key[4]);
+            nadded += sqlite3_changes(m_db);
+        }
+        sqlite3_reset(m_insert);
+        exec("COMMIT");
+    } catch (...) {
+        sqlite3_reset(m_insert);
+        sqlite3_exec(m_db, "ROLLBACK", NULL, NULL, NULL);
+        throw;
+    }
+    return nadded;
+}
+
+void ResultsDB::query(const std::string& sql, const RowFunc& fn)
+{
+    const char* tail = sql.c_str();
+    while(*tail != '\0')
+    {
+        sqlite3_stmt* stmt = NULL;
+        check(sqlite3_prepare_v2(m_db, tail, -1, &stmt, &tail), "query");
+        // Whitespace or comments only
+        if(stmt == NULL)
+            break;
+
+        const int ncol = sqlite3_column_count(stmt);
+        std::vector<std::string> names;
+        for(int i = 0; i < ncol; i++)
+            names.push_back(sqlite3_column_name(stmt, i));
+
+        int rc;
+        while((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+        {
+            json values = json::array();
+            for(int i = 0; i < ncol; i++)
+            {
+                switch(sqlite3_column_type(stmt, i))
+                {
+                    case SQLITE_INTEGER:
+                        values.push_back(sqlite3_column_int64(stmt, i));
+                        break;
+                    case SQLITE_FLOAT:
+                        values.push_back(sqlite3_column_double(stmt, i));
+                        break;
+                    case SQLITE_NULL:
+                        values.push_back(nullptr);
+                        break;
+                    default:
+                        values.push_back(std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, i)),
+                                                     sqlite3_column_bytes(stmt, i)));
+                }
+            }
+            fn(names, values);
+        }
+        const std::string msg = sqlite3_errmsg(m_db);
+        sqlite3_finalize(stmt);
+        if(rc != SQLITE_DONE)
+            throw std::runtime_error("query: " + msg);
+    }
+}
+
+std::string config_hash(const json& config)
+{
+    SHA256 sha;
+    sha.update(config.is_null() ? std::string("{}") : config.dump());
+    return sha.hexdigest().substr(0, 16);
+}
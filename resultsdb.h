@@ -0,0 +1,71 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_RESULTSDB_H
+#define CUTEST_RESULTSDB_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "json.hpp"
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+// Records of many runs in an SQLite database
+//
+// Each run (one invocation of run_suite.out, or one imported log) is a row
+// of the table runs (id, label, started, source). The records are rows of
+// the table results, keyed by (run_id, problem, alg, solver, config_hash),
+// with one column per field of CUTEstStat, the timing statistics as
+// timing_nrep, timing_median, etc., the config as JSON and the whole record
+// as JSON in "record", which json_extract() can query. Adding a record twice
+// to a run is an error. Records without a problem name, written by older
+// versions when a problem failed before CUTEst reported its name, have a
+// NULL problem and never conflict. The view solver_pairs puts the Classic
+// and LBFGS++ results of the same run, problem, algorithm and config side
+// by side, and queries can use the aggregate median()
+//
+// Records are added in one transaction per call, so that a crashed run
+// keeps the results written so far. The database uses write-ahead logging
+// and waits for locks, so shards of a run can write to it concurrently.
+// Errors throw std::runtime_error
+class ResultsDB
+{
+private:
+    sqlite3*      m_db;
+    sqlite3_stmt* m_insert;   // Prepared insertion of a record
+
+    void exec(const std::string& sql);
+    void check(int rc, const std::string& what) const;
+
+public:
+    // Open the database at path, creating it if needed
+    explicit ResultsDB(const std::string& path);
+    ~ResultsDB();
+
+    // Add a run and return its id. started is an ISO 8601 time, the
+    // current time if empty
+    long long add_run(const std::string& label, const std::string& source,
+                      const std::string& started = "");
+
+    // Add the records of a run, all or none of them, and return the number
+    // of rows inserted
+    int add(long long run, const std::vector<nlohmann::json>& records);
+
+    // Run SQL statements, passing each row to fn with the column names and
+    // an array of the values
+    using RowFunc = std::function<void(const std::vector<std::string>& names, const nlohmann::json& values)>;
+    void query(const std::string& sql, const RowFunc& fn);
+
+private:
+    ResultsDB(const ResultsDB&);
+    ResultsDB& operator=(const ResultsDB&);
+};
+
+// Key of the config of a record: the first 16 hex digits of the SHA-256 of
+// its dump(), with a missing config counting as {}
+std::string config_hash(const nlohmann::json& config);
+
+
+#endif  // CUTEST_RESULTSDB_H
@@ -2,34 +2,65 @@
 // Under MIT license
 
 #include "interface.h"
+#include "results.h"
 
-int main()
+int run_boxconstr(const std::vector<std::string>& solvers, const SolverConfig& config)
 {
     using json = nlohmann::json;
 
+    // By default all solvers are run
+    bool run_classic = solvers.empty(), run_lbfgspp = solvers.empty();
+    for(const std::string& solver: solvers)
+    {
+        if(solver == "Classic")
+        {
+            run_classic = true;
+        } else if(solver == "LBFGS++") {
+            run_lbfgspp = true;
+        } else {
+            std::cerr << "Unknown solver " << solver << std::endl;
+            return 1;
+        }
+    }
+
+    // Replaced by the name from CUTEst once the problem is set up
     CUTEstStat stat1, stat2;
+    stat1.prob = stat2.prob = problem_dir_name();
 
-    boxconstr_lbfgsb_stat(stat1, false);
-    json lbfgsb = stat_to_json(stat1);
-    lbfgsb["alg"] = "L-BFGS-B";
-    lbfgsb["solver"] = "Classic";
+    if(run_classic)
+    {
+        boxconstr_lbfgsb_stat(stat1, config, false);
+        progress_finish();
+        json lbfgsb = stat_to_json(stat1);
+        lbfgsb["alg"] = "L-BFGS-B";
+        lbfgsb["solver"] = "Classic";
+        if(!config.empty())
+            lbfgsb["config"] = config.to_json();
+        // Print as soon as possible, so the record is kept even if
+        // the next solver is killed by run_suite.out
+        write_record(std::cout, lbfgsb);
+    }
 
     // std::cout << "#####################################################" << std::endl;
     // std::cout << "Solver                = L-BFGS-B" << std::endl;
     // print_stat(stat1);
 
-    boxconstr_lbfgspp_stat(stat2, false);
-    json lbfgspp = stat_to_json(stat2);
-    lbfgspp["alg"] = "L-BFGS-B";
-    lbfgspp["solver"] = "LBFGS++";
+    if(run_lbfgspp)
+    {
+        boxconstr_lbfgspp_stat(stat2, config, false);
+        progress_finish();
+        json lbfgspp = stat_to_json(stat2);
+        lbfgspp["alg"] = "L-BFGS-B";
+        lbfgspp["solver"] = "LBFGS++";
+        if(!config.empty())
+            lbfgspp["config"] = config.to_json();
+        write_record(std::cout, lbfgspp);
+    }
 
     // std::cout << "#####################################################" << std::endl;
     // std::cout << "Solver                = LBFGS++" << std::endl;
     // print_stat(stat2);
     // std::cout << "#####################################################" << std::endl;
 
-    std::cout << lbfgsb.dump(2) << std::endl;
-    std::cout << lbfgspp.dump(2) << std::endl;
-
     return 0;
 }
@@ -0,0 +1,503 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <map>
+#include <algorithm>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "suite.h"
+#include "cache.h"
+#include "param.h"
+#include "sweep.h"
+#include "shard.h"
+#include "affinity.h"
+#include "cachegrind.h"
+#include "results.h"
+#include "resultsdb.h"
+#include "paths.h"
+
+void print_usage()
+{
+    std::cerr << "Usage: run_suite.out [-j nworker] [-p program] [-t timeout] [-m max_rss] [-c cache_dir] [-s]" << std::endl;
+    std::cerr << "                     [--solver NAME]... [--config FILE] [--sweep FILE] [--sweep-out DIR]" << std::endl;
+    std::cerr << "                     [--shard i/k] [--history LOG]... [--pin | --pin-smt] [--cachegrind DIR]" << std::endl;
+    std::cerr << "                     [--profile HZ] [--slowest N] [--db FILE] [--label NAME] DIR..." << std::endl;
+    std::cerr << "  -j nworker   Number of problems run in parallel (default: number of cores)" << std::endl;
+    std::cerr << "  -p program   Program executed in each problem directory (default: ./run.out)" << std::endl;
+    std::cerr << "  -t timeout   Wall-clock limit per problem in seconds (default: 0, no limit)" << std::endl;
+    std::cerr << "  -m max_rss   Resident memory limit per problem in MB (default: 0, no limit)" << std::endl;
+    std::cerr << "  -c cache_dir Reuse results stored in cache_dir, and store new ones there" << std::endl;
+    std::cerr << "  -s           Use the program as a fork server (driver.out only)" << std::endl;
+    std::cerr << "  --solver     Run only this solver (Classic or LBFGS++), can be repeated" << std::endl;
+    std::cerr << "  --config     JSON file of solver parameters passed to every job" << std::endl;
+    std::cerr << "  --sweep      JSON grid of solver parameters, every problem is run with each" << std::endl;
+    std::cerr << "               configuration of the grid on top of --config (see sweep.h)" << std::endl;
+    std::cerr << "  --sweep-out  Also write the records of each configuration to DIR/config_NNN.log," << std::endl;
+    std::cerr << "               and the list of configurations to DIR/configs.json" << std::endl;
+    std::cerr << "  --shard      Run only the i-th of k shards of the problems (0 <= i < k), balanced" << std::endl;
+    std::cerr << "               by the solve times of the --history logs (see shard.h)" << std::endl;
+    std::cerr << "  --history    Log of a previous run, can be repeated. Jobs are started longest" << std::endl;
+    std::cerr << "               first according to the estimated costs (see history.h)" << std::endl;
+    std::cerr << "  --pin        Pin each worker to its own physical core, leaving SMT siblings idle;" << std::endl;
+    std::cerr << "               the number of workers is limited to the number of cores" << std::endl;
+    std::cerr << "  --pin-smt    Same as --pin, using SMT siblings once every core has a worker" << std::endl;
+    std::cerr << "  --cachegrind Run each solver under Cachegrind, keeping its output in DIR, and add" << std::endl;
+    std::cerr << "               the instruction counts and simulated cache misses to the records" << std::endl;
+    std::cerr << "               (see cachegrind.h). Not compatible with -c and -s" << std::endl;
+    std::cerr << "  --profile    Sample the solves at HZ, writing profile_<solver>.folded to each" << std::endl;
+    std::cerr << "               problem directory (see profile.h). Not compatible with -c, nor are" << std::endl;
+    std::cerr << "               the trace and timeline parameters" << std::endl;
+    std::cerr << "  --slowest    Run only the N problems with the largest estimated costs" << std::endl;
+    std::cerr << "               according to --history" << std::endl;
+    std::cerr << "  --db         Also add the records to the results database FILE as a new run," << std::endl;
+    std::cerr << "               one transaction per job (see resultsdb.h)" << std::endl;
+    std::cerr << "  --label      Label of the run in the database" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    using json = nlohmann::json;
+
+    int nworker = std::thread::hardware_concurrency();
+    std::string program = "./run.out";
+    SuiteLimits limits;
+    limits.timeout = 0.0;
+    limits.max_rss = 0.0;
+    std::string cache_dir;
+    bool server = false;
+    int pin = 0;  // 0-no pinning, 1-one worker per core, 2-also on SMT siblings
+    std::vector<std::string> solvers;
+    SolverConfig config;
+    std::string sweep_file, sweep_out;
+    std::string cachegrind_dir;
+    int profile_hz = 0, nslowest = 0;
+    std::string db_file, db_label;
+    int shard_index = 0, nshard = 1;
+    SolveHistory history;
+    std::vector<SuiteJob> jobs;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(std::strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            nworker = std::atoi(argv[++i]);
+        } else if(std::strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            program = argv[++i];
+        } else if(std::strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            limits.timeout = std::atof(argv[++i]);
+        } else if(std::strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            limits.max_rss = std::atof(argv[++i]);
+        } else if(std::strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if(std::strcmp(argv[i], "-s") == 0) {
+            server = true;
+        } else if(std::strcmp(argv[i], "--solver") == 0 && i + 1 < argc) {
+            solvers.push_back(argv[++i]);
+        } else if(std::strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            try {
+                config.merge_file(argv[++i]);
+            } catch (std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+        } else if(std::strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) {
+            sweep_file = argv[++i];
+        } else if(std::strcmp(argv[i], "--sweep-out") == 0 && i + 1 < argc) {
+            sweep_out = argv[++i];
+        } else if(std::strcmp(argv[i], "--shard") == 0 && i + 1 < argc) {
+            try {
+                parse_shard(argv[++i], shard_index, nshard);
+            } catch (std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+        } else if(std::strcmp(argv[i], "--history") == 0 && i + 1 < argc) {
+            try {
+                history.add_file(argv[++i]);
+            } catch (std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+        } else if(std::strcmp(argv[i], "--pin") == 0) {
+            pin = 1;
+        } else if(std::strcmp(argv[i], "--pin-smt") == 0) {
+            pin = 2;
+        } else if(std::strcmp(argv[i], "--cachegrind") == 0 && i + 1 < argc) {
+            cachegrind_dir = argv[++i];
+        } else if(std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profile_hz = std::atoi(argv[++i]);
+        } else if(std::strcmp(argv[i], "--slowest") == 0 && i + 1 < argc) {
+            nslowest = std::atoi(argv[++i]);
+        } else if(std::strcmp(argv[i], "--db") == 0 && i + 1 < argc) {
+            db_file = argv[++i];
+        } else if(std::strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+            db_label = argv[++i];
+        } else if(argv[i][0] == '-') {
+            print_usage();
+            return 1;
+        } else {
+            SuiteJob job;
+            job.path = argv[i];
+            jobs.push_back(job);
+        }
+    }
+    if(jobs.empty())
+    {
+        print_usage();
+        return 1;
+    }
+    for(const std::string& solver: solvers)
+    {
+        if(solver != "Classic" && solver != "LBFGS++")
+        {
+            std::cerr << "Unknown solver " << solver << std::endl;
+            return 1;
+        }
+    }
+
+    // Cachegrind runs are far slower and their times are meaningless, so
+    // they are neither cached nor run through the fork server
+    std::string valgrind;
+    if(!cachegrind_dir.empty())
+    {
+        if(server || !cache_dir.empty())
+        {
+            std::cerr << "--cachegrind cannot be used with -c or -s" << std::endl;
+            return 1;
+        }
+        valgrind = find_in_path("valgrind");
+        if(valgrind.empty())
+        {
+            std::cerr << "Cannot find valgrind in PATH" << std::endl;
+            return 1;
+        }
+        if(mkdir(cachegrind_dir.c_str(), 0755) != 0 && errno != EEXIST)
+        {
+            std::cerr << cachegrind_dir << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        // Jobs run in the problem directories
+        if(cachegrind_dir[0] != '/')
+        {
+            char cwd[4096];
+            if(getcwd(cwd, sizeof(cwd)) != NULL)
+                cachegrind_dir = std::string(cwd) + "/" + cachegrind_dir;
+        }
+    }
+
+    if(profile_hz > 0)
+        config.set("profile", std::to_string(profile_hz));
+
+    // Keep the most expensive problems only, e.g. to profile them
+    if(nslowest > 0)
+    {
+        if(history.empty())
+        {
+            std::cerr << "--slowest requires --history" << std::endl;
+            return 1;
+        }
+        std::vector<std::pair<double, std::string>> costs;
+        for(const SuiteJob& job: jobs)
+            costs.push_back(std::make_pair(history.estimate(job.path), job.path));
+        std::stable_sort(costs.begin(), costs.end(),
+            [](const std::pair<double, std::string>& a, const std::pair<double, std::string>& b) {
+                return a.first > b.first;
+            });
+        if(costs.size() > std::size_t(nslowest))
+            costs.resize(nslowest);
+        jobs.clear();
+        for(const auto& cost: costs)
+        {
+            SuiteJob job;
+            job.path = cost.second;
+            jobs.push_back(job);
+        }
+    }
+
+    // Keep the problems of this shard only
+    if(nshard > 1)
+    {
+        std::vector<std::string> paths;
+        for(const SuiteJob& job: jobs)
+            paths.push_back(job.path);
+        paths = shard_problems(paths, shard_index, nshard, history);
+        std::cerr << "# Shard " << shard_index << "/" << nshard << ": "
+                  << paths.size() << " of " << jobs.size() << " problems" << std::endl;
+        jobs.clear();
+        for(const std::string& path: paths)
+        {
+            SuiteJob job;
+            job.path = path;
+            jobs.push_back(job);
+        }
+    }
+
+    // The configuration applies to all problems, wherever it was given,
+    // and a sweep runs every problem once per configuration of the grid
+    std::vector<json> configs(1, config.to_json());
+    if(!sweep_file.empty())
+    {
+        try {
+            configs = expand_grid_file(sweep_file, config.to_json());
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+    // Profiles, traces and timelines are written by the solves, so cached
+    // results would leave them missing or stale
+    if(!cache_dir.empty())
+    {
+        for(const json& conf: configs)
+        {
+            const std::vector<std::string> names = file_params(conf);
+            if(!names.empty())
+            {
+                std::cerr << "-c cannot be used with the parameter " << names[0]
+                          << (names[0] == "profile" ? " (--profile)" : "") << std::endl;
+                return 1;
+            }
+        }
+    }
+    std::map<std::string, int> config_index;
+    for(std::size_t i = 0; i < configs.size(); i++)
+        config_index[configs[i].dump()] = i;
+    {
+        std::vector<SuiteJob> expanded;
+        for(const json& conf: configs)
+        {
+            for(const SuiteJob& prob: jobs)
+            {
+                SuiteJob job = prob;
+                job.config = conf;
+                expanded.push_back(job);
+            }
+        }
+        jobs.swap(expanded);
+    }
+
+    // One log file per configuration, in the format of run.log
+    std::vector<std::unique_ptr<std::ofstream>> tables;
+    if(!sweep_out.empty())
+    {
+        if(mkdir(sweep_out.c_str(), 0755) != 0 && errno != EEXIST)
+        {
+            std::cerr << sweep_out << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        std::ofstream index(sweep_out + "/configs.json");
+        json list = json::array();
+        for(std::size_t i = 0; i < configs.size(); i++)
+        {
+            char name[32];
+            std::snprintf(name, sizeof(name), "config_%03d.log", int(i));
+            tables.emplace_back(new std::ofstream(sweep_out + "/" + name));
+            list.push_back(json{ { "file", name }, { "config", configs[i] } });
+        }
+        index << list.dump(2) << std::endl;
+        if(!index)
+        {
+            std::cerr << sweep_out << ": cannot write configs.json" << std::endl;
+            return 1;
+        }
+    }
+
+    // The run is added to the database before the jobs start, and the
+    // records of each job as soon as it finishes
+    std::unique_ptr<ResultsDB> db;
+    long long db_run = 0;
+    if(!db_file.empty())
+    {
+        std::string command = argv[0];
+        for(int i = 1; i < argc; i++)
+            command += std::string(" ") + argv[i];
+        try {
+            db.reset(new ResultsDB(db_file));
+            db_run = db->add_run(db_label, command);
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    int nrecord = 0, nfail = 0, ncached = 0;
+
+    // Write the records of a job to stdout, to the table of its configuration
+    // and to the database, with the CPU the job ran on if the workers are pinned
+    auto emit = [&](const SuiteJob& job, const std::vector<json>& records, int cpu) {
+        std::ostream* table = NULL;
+        if(!tables.empty())
+            table = tables[config_index[job.config.dump()]].get();
+        std::vector<json> written;
+        for(json rec: records)
+        {
+            if(cpu >= 0)
+                rec["cpu"] = cpu;
+            write_record(std::cout, rec);
+            if(table)
+                write_record(*table, rec);
+            written.push_back(rec);
+        }
+        nrecord += records.size();
+        if(db)
+        {
+            // A failed write is reported, the records are still in the log
+            try {
+                db->add(db_run, written);
+            } catch (std::exception& e) {
+                std::cerr << "# " << db_file << ": " << e.what() << std::endl;
+            }
+        }
+    };
+
+    // With a cache, a selection of solvers, a sweep or Cachegrind, each
+    // solver is a separate job
+    if(!cache_dir.empty() || !solvers.empty() || configs.size() > 1 || !cachegrind_dir.empty())
+    {
+        if(solvers.empty())
+        {
+            solvers.push_back("Classic");
+            solvers.push_back("LBFGS++");
+        }
+        std::vector<SuiteJob> split;
+        for(const SuiteJob& prob: jobs)
+        {
+            for(const std::string& solver: solvers)
+            {
+                SuiteJob job = prob;
+                job.solver = solver;
+                split.push_back(job);
+            }
+        }
+        jobs.swap(split);
+    }
+
+    // Only the (problem, solver) pairs that are not in the cache are run
+    std::unique_ptr<ResultCache> cache;
+    if(!cache_dir.empty())
+    {
+        cache.reset(new ResultCache(cache_dir));
+        std::vector<SuiteJob> pending;
+        for(SuiteJob& job: jobs)
+        {
+            job.key = cache->key(job);
+            std::vector<json> records;
+            if(!job.key.empty() && cache->lookup(job.key, records))
+            {
+                emit(job, records, -1);
+                ncached++;
+            } else {
+                pending.push_back(job);
+            }
+        }
+        jobs.swap(pending);
+    }
+
+    // Longest jobs first, so that no large problem is started at the end
+    // of the run. Workers take the jobs from one shared queue, so the order
+    // holds across all workers
+    double total_cost = 0.0;
+    for(SuiteJob& job: jobs)
+    {
+        job.cost = history.estimate(job.path, job.solver);
+        total_cost += job.cost;
+    }
+    std::stable_sort(jobs.begin(), jobs.end(), [](const SuiteJob& a, const SuiteJob& b) {
+        return a.cost > b.cost;
+    });
+
+    // Progress and estimated time left, from the ratio of the actual and
+    // estimated run times of the finished jobs
+    std::vector<int> cpus;
+    if(pin)
+    {
+        cpus = worker_cpus(nworker, pin == 2);
+        if(cpus.empty())
+        {
+            std::cerr << "Cannot determine the CPUs to pin the workers to" << std::endl;
+            return 1;
+        }
+        if(int(cpus.size()) < nworker)
+            std::cerr << "# Pinning " << cpus.size() << " workers instead of " << nworker << std::endl;
+        nworker = cpus.size();
+    }
+    const int nactive = std::max(1, std::min(nworker, int(jobs.size())));
+    std::size_t nfinished = 0;
+    double done_cost = 0.0, done_time = 0.0;
+    auto last_report = std::chrono::steady_clock::now();
+
+    // Cachegrind output of a job, DIR/<problem>_<solver>_<config>.out
+    auto cachegrind_file = [&](const SuiteJob& job) {
+        char suffix[16];
+        std::snprintf(suffix, sizeof(suffix), "_%03d.out", config_index.at(job.config.dump()));
+        return cachegrind_dir + "/" + path_basename(job.path) + "_" + job.solver + suffix;
+    };
+
+    SuiteRunner runner(nworker, program);
+    runner.set_limits(limits);
+    runner.set_server(server);
+    runner.set_cpus(cpus);
+    if(!cachegrind_dir.empty())
+    {
+        // cachegrind_file() only reads config_index
+        runner.set_wrapper([&](const SuiteJob& job) {
+            return cachegrind_command(valgrind, cachegrind_file(job));
+        });
+    }
+    runner.run(jobs, [&](const SuiteJob& job, const SuiteResult& res) {
+        // Records are written as soon as each problem finishes
+        if(cachegrind_dir.empty())
+        {
+            emit(job, res.records, res.cpu);
+        } else {
+            const json counts = read_cachegrind(cachegrind_file(job));
+            std::vector<json> records = res.records;
+            for(json& rec: records)
+            {
+                if(!counts.is_null())
+                    rec["cachegrind"] = counts;
+            }
+            emit(job, records, res.cpu);
+        }
+        nfinished++;
+        done_cost += job.cost;
+        done_time += res.wall_time;
+        const auto now = std::chrono::steady_clock::now();
+        if(now - last_report >= std::chrono::seconds(10) && nfinished < jobs.size() && done_cost > 0.0)
+        {
+            const double eta = done_time / done_cost * (total_cost - done_cost) / nactive;
+            std::cerr << "# " << nfinished << "/" << jobs.size() << " jobs done, ETA "
+                      << int(eta + 0.5) << " s" << std::endl;
+            last_report = now;
+        }
+        // Only results of normal exits are reusable
+        if(cache && !job.key.empty() && res.status == 0 && !res.killed && !res.records.empty())
+            cache->store(job.key, res.records);
+        if(res.killed)
+        {
+            nfail++;
+            std::cerr << "# " << job.path << ": killed after " << res.wall_time << " s ("
+                      << (res.killed == 3 ? "wall-clock" : "memory") << " limit)" << std::endl;
+        } else if(res.status != 0) {
+            nfail++;
+            std::cerr << "# " << job.path << ": exit status " << res.status << std::endl;
+        }
+    });
+    const auto end = std::chrono::steady_clock::now();
+
+    std::cerr << "# " << jobs.size() << " jobs run, " << ncached << " cached, " << nrecord << " records, "
+              << nfail << " abnormal exits, "
+              << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+
+    return 0;
+}
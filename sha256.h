@@ -0,0 +1,34 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_SHA256_H
+#define CUTEST_SHA256_H
+
+#include <string>
+#include <cstdint>
+
+// Incremental SHA-256, used to compute content-based cache keys
+class SHA256
+{
+private:
+    std::uint32_t m_state[8];
+    unsigned char m_block[64];
+    std::uint64_t m_len;      // Number of bytes processed
+    std::size_t   m_fill;     // Number of bytes in m_block
+
+    void compress(const unsigned char* block);
+
+public:
+    SHA256();
+
+    void update(const void* data, std::size_t len);
+    void update(const std::string& str) { update(str.data(), str.size()); }
+    // Hash the content of a file, returning false if it cannot be read
+    bool update_file(const std::string& path);
+
+    // Finish hashing and return the digest as a hex string
+    std::string hexdigest();
+};
+
+
+#endif  // CUTEST_SHA256_H
@@ -0,0 +1,67 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+#include <cstdlib>
+#include "shard.h"
+#include "paths.h"
+
+void parse_shard(const std::string& spec, int& index, int& nshard)
+{
+    const char* begin = spec.c_str();
+    char* end;
+    index = int(std::strtol(begin, &end, 10));
+    if(end == begin || *end != '/')
+        throw std::invalid_argument("shard must be given as i/k");
+    begin = end + 1;
+    nshard = int(std::strtol(begin, &end, 10));
+    if(end == begin || *end != '\0' || nshard < 1 || index < 0 || index >= nshard)
+        throw std::invalid_argument("shard must be given as i/k, with 0 <= i < k");
+}
+
+std::vector<std::string> shard_problems(const std::vector<std::string>& paths,
+                                        int index, int nshard, const SolveHistory& history)
+{
+    struct Item
+    {
+        std::string name;
+        std::string path;
+        double      cost;
+    };
+
+    std::vector<Item> items;
+    for(const std::string& path: paths)
+    {
+        Item item;
+        item.name = path_basename(path);
+        item.path = path;
+        item.cost = history.estimate(path);
+        items.push_back(item);
+    }
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+        if(a.cost != b.cost)
+            return a.cost > b.cost;
+        return (a.name != b.name) ? (a.name < b.name) : (a.path < b.path);
+    });
+
+    std::vector<double> load(nshard, 0.0);
+    std::set<std::string> selected;
+    for(const Item& item: items)
+    {
+        const int dest = int(std::min_element(load.begin(), load.end()) - load.begin());
+        load[dest] += item.cost;
+        if(dest == index)
+            selected.insert(item.path);
+    }
+
+    // Keep the order of the command line
+    std::vector<std::string> res;
+    for(const std::string& path: paths)
+    {
+        if(selected.count(path))
+            res.push_back(path);
+    }
+    return res;
+}
@@ -0,0 +1,27 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_SHARD_H
+#define CUTEST_SHARD_H
+
+#include <string>
+#include <vector>
+#include "history.h"
+
+// Parse "i/k" into a shard index (0 <= i < k) and a number of shards,
+// throwing std::invalid_argument on errors
+void parse_shard(const std::string& spec, int& index, int& nshard);
+
+// Problem directories of shard index out of nshard
+//
+// The problems are sorted by decreasing cost in the history, ties broken by
+// name, and each is assigned to the shard with the smallest total cost so
+// far, the lowest index among equals. Problems missing from the history
+// are estimated as in SolveHistory::estimate(). The result only depends on
+// the problems and on the history, so every host computes the same
+// partition as long as it is given the same problem list and history logs
+std::vector<std::string> shard_problems(const std::vector<std::string>& paths,
+                                        int index, int nshard, const SolveHistory& history);
+
+
+#endif  // CUTEST_SHARD_H
@@ -195,6 +195,8 @@ c                                                         Cauchy points;
 c         dsave(8) = the accumulated time spent on
 c                                                 subspace minimization;
 c         dsave(9) = the accumulated time spent on line search;
+c       These three times are only measured if isave(24) is set to a
+c       nonzero value before the first call, and are zero otherwise.
 c         dsave(11) = the slope of the line search function at
 c                                  the current point of line search;
 c         dsave(12) = the maximum relative step length imposed in
@@ -524,19 +526,28 @@ c     ************
      +                 iword,nfree,nact,ileave,nenter
 cj itmp for use in R output
       integer          itmp
+c     itimer = isave(3): nonzero to time the phases, see setulb
+      integer          itimer
       double precision theta,fold,ddot,dr,rr,tol,
      +                 xstep,sbgnrm,ddum,dnorm,dtd,epsmch,
-     +                 cpu1,cpu2,sbtime,lnscht,time1,time2,
+     +                 cpu1,cpu2,cachyt,sbtime,lnscht,time1,time2,
      +                 gd,gdold,stp,stpmx,time
       double precision one,zero
       parameter        (one=1.0d0,zero=0.0d0)
+
+c     The timers are only read if the caller asked for the phase times,
+c     the times are zero otherwise.
+      itimer = isave(3)
+      cpu2   = zero
+      time2  = zero
       
       if (itask .eq. 2) then
 
          epsmch = epsilon(one)
 
-cj Arbitrarily zero these.
-         time1 = 0.0
+c        Start the clock of the total running time.
+         time1 = zero
+         if (itimer .ne. 0) call timer(time1)
 
 c        Initialize counters and scalars when task='START'.
 
@@ -574,7 +585,7 @@ c           for stopping tolerance:
          tol = factr*epsmch
 
 c           for measuring running time:
-cy         cachyt = 0
+         cachyt = 0
          sbtime = 0
          lnscht = 0
  
@@ -641,7 +652,7 @@ cy         itfile = isave(3)
          dnorm  = dsave(4)
          epsmch = dsave(5)
          cpu1   = dsave(6)
-cy         cachyt = dsave(7)
+         cachyt = dsave(7)
          sbtime = dsave(8)
          lnscht = dsave(9)
          time1  = dsave(10)
@@ -722,8 +733,7 @@ c     Compute the Generalized Cauchy Point (GCP).
 c
 cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
-cj      call timer(cpu1) 
-      cpu1 = 0.0d0
+      if (itimer .ne. 0) call timer(cpu1)
       call cauchy(n,x,l,u,nbd,g,indx2,iwhere,t,d,z,
      +            m,wy,ws,sy,wt,theta,col,head,
      +            wa(1),wa(2*m+1),wa(4*m+1),wa(6*m+1),nseg,
@@ -741,12 +751,12 @@ cx     +    -1,0,0)
          theta  = one
          iupdat = 0
          updatd = .false.
-         cpu2 = 0.0d0
-cy         cachyt = cachyt + cpu2 - cpu1
+         if (itimer .ne. 0) call timer(cpu2)
+         cachyt = cachyt + cpu2 - cpu1
          goto 222
       endif
-      cpu2 = 0.0d0
-cy      cachyt = cachyt + cpu2 - cpu1
+      if (itimer .ne. 0) call timer(cpu2)
+      cachyt = cachyt + cpu2 - cpu1
       nintol = nintol + nseg
 
 c     Count the entering and leaving variables for iter > 0; 
@@ -769,7 +779,7 @@ c     Subspace minimization.
 c
 cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
-      cpu1 = 0.0d0
+      if (itimer .ne. 0) call timer(cpu1)
 
 c     Form  the LEL^T factorization of the indefinite
 c       matrix    K = [-D -Y'ZZ'Y/theta     L_a'-R_z'  ]
@@ -799,8 +809,7 @@ cx     + -1, 0, 0)
          theta  = one
          iupdat = 0
          updatd = .false.
-cj       call timer(cpu2) 
-         cpu2 = 0.0d0
+         if (itimer .ne. 0) call timer(cpu2)
          sbtime = sbtime + cpu2 - cpu1 
          goto 222
       endif 
@@ -830,14 +839,12 @@ cx     +    -1,0,0)
          theta  = one
          iupdat = 0
          updatd = .false.
-cj       call timer(cpu2) 
-         cpu2 = 0.0d0
+         if (itimer .ne. 0) call timer(cpu2)
          sbtime = sbtime + cpu2 - cpu1 
          goto 222
       endif
  
-cj       call timer(cpu2) 
-         cpu2 = 0.0d0
+      if (itimer .ne. 0) call timer(cpu2)
       sbtime = sbtime + cpu2 - cpu1 
  555  continue
  
@@ -852,8 +859,7 @@ c     Generate the search direction d:=z-x.
       do 40 i = 1, n
          d(i) = z(i) - x(i)
   40  continue
-cj    call timer(cpu1) 
-      cpu1 = 0.0d0
+      if (itimer .ne. 0) call timer(cpu1)
  666  continue
       call lnsrlb(n,l,u,nbd,x,f,fold,gd,gdold,g,d,r,t,z,stp,dnorm,
      +            dtd,xstep,stpmx,iter,ifun,iback,nfgv,info,itask,
@@ -897,8 +903,7 @@ cx     + -1, 0, 0)
             updatd = .false.
 c            task   = 'RESTART_FROM_LNSRCH'
             itask = 22
-cj       call timer(cpu2) 
-         cpu2 = 0.0d0
+            if (itimer .ne. 0) call timer(cpu2)
             lnscht = lnscht + cpu2 - cpu1
             goto 222
          endif
@@ -908,8 +913,7 @@ c          return to the driver for calculating f and g; reenter at 666.
          goto 1000
       else 
 c          calculate and print out the quantities related to the new X.
-cj       call timer(cpu2) 
-         cpu2 = 0.0d0
+         if (itimer .ne. 0) call timer(cpu2)
          lnscht = lnscht + cpu2 - cpu1
          iter = iter + 1
  
@@ -1028,8 +1032,7 @@ c -------------------- the end of the loop -----------------------------
  
       goto 222
  999  continue
-cj    call timer(time2)
-      time2 = 0.0d0
+      if (itimer .ne. 0) call timer(time2)
       time = time2 - time1
       call prn3lb(n,x,f,itask,iprint,info,k)
  1000 continue
@@ -1066,7 +1069,7 @@ cy      isave(3)  = itfile
       dsave(4)  = dnorm 
       dsave(5)  = epsmch 
       dsave(6)  = cpu1 
-cy      dsave(7)  = cachyt 
+      dsave(7)  = cachyt 
       dsave(8)  = sbtime 
       dsave(9)  = lnscht 
       dsave(10) = time1 
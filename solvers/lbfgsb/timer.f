@@ -6,11 +6,14 @@ c
       subroutine timer(ttime)
       double precision ttime
 c
-      real temp
+      integer*8 count, rate
 c
-c     This routine computes cpu time in double precision; it makes use of 
-c     the intrinsic f90 cpu_time therefore a conversion type is
-c     needed.
+c     This routine returns the time in seconds of a monotonic wall clock,
+c     which only makes sense as a difference between two calls. It is
+c     used for the phase times of mainlb (Cauchy point, subspace
+c     minimization and line search), which are too short for the
+c     resolution of the intrinsic cpu_time in single precision that was
+c     used in the original version.
 c
 c           J.L Morales  Departamento de Matematicas, 
 c                        Instituto Tecnologico Autonomo de Mexico
@@ -22,9 +25,8 @@ c                        Northwestern University. Evanston, IL. USA
 c                         
 c                        January 21, 2011
 c
-      temp = sngl(ttime)
-      call cpu_time(temp)
-      ttime = dble(temp) 
+      call system_clock(count, rate)
+      ttime = dble(count) / dble(rate)
 
       return
 
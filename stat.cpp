@@ -0,0 +1,85 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <iostream>
+#include "stat.h"
+#include "provenance.h"
+#include "results.h"
+
+using json = nlohmann::json;
+
+// Trim trailing whitespace
+inline std::string trim_space(const std::string& name)
+{
+    std::size_t trim = name.find_last_not_of(' ');
+    return name.substr(0, trim + 1);
+}
+
+void print_stat(const CUTEstStat& stat)
+{
+    std::cout << "Problem               = " << stat.prob << std::endl;
+    std::cout << "Flag                  = " << stat.flag << std::endl;
+    std::cout << "# variables           = " << stat.nvar << std::endl;
+    std::cout << "# iterations          = " << stat.niter << std::endl;
+    std::cout << "# function calls      = " << stat.nfun << std::endl;
+    std::cout << "Final f               = " << stat.objval << std::endl;
+    std::cout << "Final ||proj_grad||   = " << stat.proj_grad << std::endl;
+    std::cout << "Setup time            = " << stat.setup_time << " s" << std::endl;
+    std::cout << "Solve time            = " << stat.solve_time << " s" << std::endl;
+    std::cout << "Oracle time (wall)    = " << stat.oracle_time.wall << " s" << std::endl;
+    std::cout << "Solver time (wall)    = " << stat.solver_time.wall << " s" << std::endl;
+    std::cout << "Workspace             = " << stat.workspace << " bytes" << std::endl;
+    std::cout << "Peak RSS              = " << stat.memory.peak_rss << " bytes" << std::endl;
+}
+
+// Convert CUTEstStat object to JSON
+json stat_to_json(const CUTEstStat& stat)
+{
+    json data = {
+        {"schema", record_schema},
+        {"problem", trim_space(stat.prob)},
+        {"flag", stat.flag},
+        {"msg", stat.msg},
+        {"nvar", stat.nvar},
+        {"niter", stat.niter},
+        {"nfun", stat.nfun},
+        {"ngrad", stat.ngrad},
+        {"nhess", stat.nhess},
+        {"nhprod", stat.nhprod},
+        {"objval", stat.objval},
+        {"proj_grad", stat.proj_grad},
+        {"setup_time", stat.setup_time},
+        {"solve_time", stat.solve_time},
+        {"oracle_wall", stat.oracle_time.wall},
+        {"oracle_cpu", stat.oracle_time.cpu},
+        {"solver_wall", stat.solver_time.wall},
+        {"solver_cpu", stat.solver_time.cpu},
+        {"workspace", stat.workspace},
+        {"peak_rss", stat.memory.peak_rss},
+        {"minor_faults", stat.memory.minor_faults},
+        {"major_faults", stat.memory.major_faults}
+    };
+    if(!stat.perf.is_null())
+        data["perf"] = stat.perf;
+    if(!stat.phases.is_null())
+        data["phases"] = stat.phases;
+    if(!stat.alloc.is_null())
+        data["alloc"] = stat.alloc;
+    if(!stat.profile.is_null())
+        data["profile"] = stat.profile;
+    data["env"] = run_provenance();
+    if(stat.timing.nrep > 0)
+    {
+        data["timing"] = {
+            {"nrep", stat.timing.nrep},
+            {"batch", stat.timing.batch},
+            {"warmup", stat.timing.warmup},
+            {"min", stat.timing.min},
+            {"median", stat.timing.median},
+            {"mad", stat.timing.mad},
+            {"ci_lower", stat.timing.ci_lower},
+            {"ci_upper", stat.timing.ci_upper}
+        };
+    }
+    return data;
+}
@@ -0,0 +1,52 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_STAT_H
+#define CUTEST_STAT_H
+
+#include <string>
+#include "json.hpp"
+#include "timing.h"
+#include "memory.h"
+
+// Statistics
+struct CUTEstStat
+{
+    std::string prob;        // Problem name
+    int         flag;        // 0-normal, 1-solver error, 2-problem error,
+                             // 3-wall-clock limit reached, 4-memory limit reached
+    std::string msg;         // Error message
+    int         nvar;        // Number of variables
+    int         niter;       // Number of iterations
+    int         nfun;        // Number of function evluations
+    int         ngrad;       // Number of gradient evaluations
+    int         nhess;       // Number of Hessian evaluations
+    int         nhprod;      // Number of Hessian-vector products
+    double      objval;      // Final objective function value
+    double      proj_grad;   // Final (projected) gradient
+    double      setup_time;  // Time for setup
+    double      solve_time;  // Time for solving
+    WallCpuTime oracle_time; // Time spent in CUTEst evaluations during the solve
+    WallCpuTime solver_time; // Time of the solve loop minus oracle_time
+    RepeatTiming timing;     // Repeated timing of the solve, if requested
+    nlohmann::json perf;     // Hardware counters of the solve (see perf.h), null if not measured
+    nlohmann::json phases;   // Phase times of the L-BFGS-B solvers, null if not measured
+    long        workspace;   // Bytes of the working arrays of the solver
+    MemoryUsage memory;      // Peak RSS and page faults of the solve
+    nlohmann::json alloc;    // Heap allocations of the solve (see alloc.h), null if not counted
+    nlohmann::json profile;  // Attribution of the profile samples (see profile.h), null if not profiled
+
+    CUTEstStat() :
+        flag(0), nvar(0), niter(0), nfun(0), ngrad(0), nhess(0), nhprod(0),
+        objval(0.0), proj_grad(0.0), setup_time(0.0), solve_time(0.0), workspace(0)
+    {}
+};
+
+// Helper functions
+void print_stat(const CUTEstStat& stat);
+
+// Convert CUTEstStat object to JSON
+nlohmann::json stat_to_json(const CUTEstStat& stat);
+
+
+#endif  // CUTEST_STAT_H
@@ -0,0 +1,504 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <limits>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <csignal>
+#include <ctime>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "suite.h"
+#include "results.h"
+#include "stat.h"
+#include "progress.h"
+#include "paths.h"
+#include "affinity.h"
+
+// Shared queue of job indices, handed out in the order of the jobs
+//
+// No job is added after construction, so the next index is all the state
+// there is. Every worker takes the first job left, which with the jobs
+// sorted by decreasing cost schedules them longest first across all workers
+class JobQueue
+{
+private:
+    std::atomic<std::size_t> m_next;
+    const std::size_t        m_njob;
+
+public:
+    explicit JobQueue(std::size_t njob) :
+        m_next(0), m_njob(njob)
+    {}
+
+    // Get the next job, returning false if no work is left
+    bool pop(std::size_t& job)
+    {
+        job = m_next.fetch_add(1);
+        return job < m_njob;
+    }
+};
+
+std::vector<std::string> job_args(const SuiteJob& job)
+{
+    std::vector<std::string> args;
+    if(!job.solver.empty())
+        args.push_back(job.solver);
+    if(job.config.is_object() && !job.config.empty())
+    {
+        args.push_back("--config-json");
+        args.push_back(job.config.dump());
+    }
+    return args;
+}
+
+SuiteRunner::SuiteRunner(int nworker, const std::string& program) :
+    m_nworker(nworker > 0 ? nworker : 1), m_program(program), m_server(false)
+{
+    m_limits.timeout = 0.0;
+    m_limits.max_rss = 0.0;
+}
+
+// Resident set size of a process in MB, or 0 if unknown
+static double process_rss(pid_t pid)
+{
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/statm", int(pid));
+    std::FILE* file = std::fopen(path, "r");
+    if(file == NULL)
+        return 0.0;
+    long size = 0, resident = 0;
+    const int nread = std::fscanf(file, "%ld %ld", &size, &resident);
+    std::fclose(file);
+    if(nread != 2)
+        return 0.0;
+    return double(resident) * sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+}
+
+// Build the record of a solve that did not finish normally
+static nlohmann::json unfinished_record(const SuiteJob& job, const CUTEstProgress& prog,
+                                        int flag, const std::string& msg, double wall_time)
+{
+    CUTEstStat stat;
+    stat.flag = flag;
+    stat.msg = msg;
+    stat.proj_grad = std::numeric_limits<double>::quiet_NaN();
+    stat.setup_time = 0.0;
+    if(prog.active)
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        stat.prob = prog.prob;
+        stat.nvar = prog.nvar;
+        stat.niter = prog.niter;
+        stat.nfun = prog.nfun;
+        stat.objval = prog.objval;
+        stat.solve_time = ts.tv_sec + 1e-9 * ts.tv_nsec - prog.start_time;
+    } else {
+        // Killed before any solver started
+        stat.prob = path_basename(job.path);
+        stat.nvar = 0;
+        stat.niter = 0;
+        stat.nfun = 0;
+        stat.objval = std::numeric_limits<double>::quiet_NaN();
+        stat.solve_time = wall_time;
+    }
+    nlohmann::json rec = stat_to_json(stat);
+    if(prog.active)
+    {
+        rec["alg"] = prog.alg;
+        rec["solver"] = prog.solver;
+    } else if(!job.solver.empty()) {
+        rec["solver"] = job.solver;
+    }
+    if(job.config.is_object() && !job.config.empty())
+        rec["config"] = job.config;
+    return rec;
+}
+
+// Shared progress record of the solve run by a worker, see progress.h
+class ProgressFile
+{
+public:
+    int             fd;
+    CUTEstProgress* data;
+
+    ProgressFile() : fd(-1), data(NULL)
+    {
+        fd = memfd_create("cutest-progress", MFD_CLOEXEC);
+        if(fd < 0 || ftruncate(fd, sizeof(CUTEstProgress)) != 0)
+            return;
+        void* addr = mmap(NULL, sizeof(CUTEstProgress), PROT_READ | PROT_WRITE,
+                          MAP_SHARED, fd, 0);
+        if(addr != MAP_FAILED)
+            data = static_cast<CUTEstProgress*>(addr);
+        reset();
+    }
+
+    ~ProgressFile()
+    {
+        if(data != NULL)
+            munmap(data, sizeof(CUTEstProgress));
+        if(fd >= 0)
+            close(fd);
+    }
+
+    void reset()
+    {
+        if(data != NULL)
+            std::memset(data, 0, sizeof(CUTEstProgress));
+    }
+};
+
+// A fork server started by a worker, see SuiteRunner::set_server()
+struct ForkServer
+{
+    pid_t       pid;
+    int         to_server;    // Write end of the server's stdin
+    int         from_server;  // Read end of the server's stdout
+    std::string pending;      // Output read but not yet processed
+
+    ForkServer() : pid(-1), to_server(-1), from_server(-1) {}
+};
+
+// Start a program with its stdout, and optionally its stdin, connected to
+// pipes. The program runs in dir, or in the current directory if dir is
+// empty, and the progress file is passed through CUTEST_PROGRESS_FD
+static pid_t spawn(const std::vector<std::string>& args, const std::string& dir,
+                   const ProgressFile& prog, int* out_fd, int* in_fd)
+{
+    // Close-on-exec, so that children spawned concurrently by other
+    // workers do not hold our pipes open
+    int out[2], in[2] = { -1, -1 };
+    if(pipe2(out, O_CLOEXEC) != 0)
+        return -1;
+    if(in_fd != NULL && pipe2(in, O_CLOEXEC) != 0)
+    {
+        close(out[0]);
+        close(out[1]);
+        return -1;
+    }
+
+    // Prepare arguments and environment before fork, since the child may
+    // only call async-signal-safe functions
+    std::vector<char*> argv;
+    for(const std::string& arg: args)
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(NULL);
+    const std::string prog_env = "CUTEST_PROGRESS_FD=" + std::to_string(prog.fd);
+    std::vector<char*> envp;
+    for(char** e = environ; *e != NULL; e++)
+    {
+        if(std::strncmp(*e, "CUTEST_PROGRESS_FD=", 19) != 0)
+            envp.push_back(*e);
+    }
+    envp.push_back(const_cast<char*>(prog_env.c_str()));
+    envp.push_back(NULL);
+
+    pid_t pid = fork();
+    if(pid == 0)
+    {
+        if(dup2(out[1], STDOUT_FILENO) < 0)
+            _exit(127);
+        if(in_fd != NULL && dup2(in[0], STDIN_FILENO) < 0)
+            _exit(127);
+        if(!dir.empty() && chdir(dir.c_str()) != 0)
+            _exit(127);
+        // Let the progress file survive exec
+        fcntl(prog.fd, F_SETFD, 0);
+        execve(argv[0], argv.data(), envp.data());
+        _exit(127);
+    }
+
+    close(out[1]);
+    if(in_fd != NULL)
+        close(in[0]);
+    if(pid < 0)
+    {
+        close(out[0]);
+        if(in_fd != NULL)
+            close(in[1]);
+        return -1;
+    }
+    *out_fd = out[0];
+    if(in_fd != NULL)
+        *in_fd = in[1];
+    return pid;
+}
+
+// Enforces the limits on the process solving a job
+class JobMonitor
+{
+private:
+    const SuiteLimits& m_limits;
+    std::chrono::steady_clock::time_point m_start;
+    double m_last_check;
+    pid_t  m_target;
+
+public:
+    int    killed;            // 0, 3 or 4 as in SuiteResult
+
+    JobMonitor(const SuiteLimits& limits) :
+        m_limits(limits), m_start(std::chrono::steady_clock::now()),
+        m_last_check(0.0), m_target(-1), killed(0)
+    {}
+
+    double elapsed() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+    // Set the process to watch, killing it at once if the job has already
+    // exceeded the limits
+    void set_target(pid_t pid)
+    {
+        m_target = pid;
+        if(killed && m_target > 0)
+            kill(m_target, SIGKILL);
+    }
+
+    // Check the limits, at most every 0.1 seconds
+    void check()
+    {
+        const double t = elapsed();
+        if(killed || t < m_last_check + 0.1)
+            return;
+        m_last_check = t;
+        if(m_limits.timeout > 0.0 && t > m_limits.timeout)
+            killed = 3;
+        else if(m_limits.max_rss > 0.0 && m_target > 0 && process_rss(m_target) > m_limits.max_rss)
+            killed = 4;
+        if(killed && m_target > 0)
+            kill(m_target, SIGKILL);
+    }
+};
+
+// Wait for data on fd for at most 0.1 seconds and append it to buffer
+// Returns false on end of file or error
+static bool read_some(int fd, std::string& buffer)
+{
+    pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    const int ready = poll(&pfd, 1, 100);
+    if(ready < 0)
+        return errno == EINTR;
+    if(ready == 0)
+        return true;
+
+    char buf[4096];
+    ssize_t n = read(fd, buf, sizeof(buf));
+    if(n > 0)
+        buffer.append(buf, n);
+    else if(n < 0 && errno == EINTR)
+        return true;
+    return n > 0;
+}
+
+// Extract the records of a finished job, and report the solve that was
+// interrupted, if any
+static void finish_result(SuiteResult& res, const SuiteJob& job, const SuiteLimits& limits,
+                          const CUTEstProgress& prog, const std::string& output)
+{
+    res.records = parse_records(output);
+
+    std::ostringstream msg;
+    if(res.killed == 3)
+    {
+        msg << "Wall-clock limit of " << limits.timeout << " s reached.";
+        res.records.push_back(unfinished_record(job, prog, 3, msg.str(), res.wall_time));
+    } else if(res.killed == 4) {
+        msg << "Memory limit of " << limits.max_rss << " MB reached.";
+        res.records.push_back(unfinished_record(job, prog, 4, msg.str(), res.wall_time));
+    } else if(res.status < 0 && prog.active) {
+        msg << "Solver crashed with signal " << -res.status << ".";
+        res.records.push_back(unfinished_record(job, prog, 1, msg.str(), res.wall_time));
+    }
+}
+
+// Run a job in a new process
+static SuiteResult execute_process(const SuiteJob& job, const std::string& program,
+                                   const SuiteRunner::Wrapper& wrapper,
+                                   const SuiteLimits& limits, ProgressFile& prog)
+{
+    SuiteResult res;
+    res.status = -1;
+    res.killed = 0;
+    res.wall_time = 0.0;
+    if(prog.data == NULL)
+        return res;
+    prog.reset();
+
+    std::vector<std::string> args = job_args(job);
+    args.insert(args.begin(), program);
+    if(wrapper)
+    {
+        const std::vector<std::string> prefix = wrapper(job);
+        args.insert(args.begin(), prefix.begin(), prefix.end());
+    }
+
+    JobMonitor monitor(limits);
+    int out_fd;
+    pid_t pid = spawn(args, job.path, prog, &out_fd, NULL);
+    if(pid < 0)
+        return res;
+    monitor.set_target(pid);
+
+    // Collect everything the program prints, and check the limits
+    // while waiting for output
+    std::string output;
+    while(read_some(out_fd, output))
+        monitor.check();
+    close(out_fd);
+
+    int wstatus = 0;
+    while(waitpid(pid, &wstatus, 0) < 0 && errno == EINTR) {}
+
+    res.wall_time = monitor.elapsed();
+    res.killed = monitor.killed;
+    if(WIFEXITED(wstatus))
+        res.status = WEXITSTATUS(wstatus);
+    else if(WIFSIGNALED(wstatus))
+        res.status = -WTERMSIG(wstatus);
+    finish_result(res, job, limits, *prog.data, output);
+    return res;
+}
+
+static void stop_server(ForkServer& server)
+{
+    if(server.pid <= 0)
+        return;
+    close(server.to_server);
+    close(server.from_server);
+    int wstatus;
+    while(waitpid(server.pid, &wstatus, 0) < 0 && errno == EINTR) {}
+    server = ForkServer();
+}
+
+// Run a job through a fork server, starting the server if needed
+//
+// The runner writes DIR and ARGS... to the server as NUL-terminated fields
+// ended by an empty field. The server forks one child per solver and
+// prints "#PID <pid>" for each child, followed by the output of the
+// children and a final "#DONE <status>" line
+static SuiteResult execute_server(const SuiteJob& job, const std::string& program,
+                                  const SuiteLimits& limits, ProgressFile& prog,
+                                  ForkServer& server)
+{
+    SuiteResult res;
+    res.status = -1;
+    res.killed = 0;
+    res.wall_time = 0.0;
+    if(prog.data == NULL)
+        return res;
+    prog.reset();
+
+    if(server.pid <= 0)
+    {
+        std::vector<std::string> args;
+        args.push_back(program);
+        args.push_back("--server");
+        server.pid = spawn(args, "", prog, &server.from_server, &server.to_server);
+        if(server.pid < 0)
+            return res;
+    }
+
+    JobMonitor monitor(limits);
+    // NUL-terminated fields, ended by an empty one (see driver.cpp)
+    std::string request = job.path;
+    request += '\0';
+    for(const std::string& arg: job_args(job))
+    {
+        request += arg;
+        request += '\0';
+    }
+    request += '\0';
+    bool done = false;
+    if(write(server.to_server, request.data(), request.size()) == ssize_t(request.size()))
+    {
+        std::string output;
+        while(!done && read_some(server.from_server, server.pending))
+        {
+            std::size_t eol;
+            while(!done && (eol = server.pending.find('\n')) != std::string::npos)
+            {
+                const std::string line = server.pending.substr(0, eol);
+                server.pending.erase(0, eol + 1);
+                if(line.compare(0, 5, "#PID ") == 0)
+                {
+                    monitor.set_target(std::atoi(line.c_str() + 5));
+                } else if(line.compare(0, 6, "#DONE ") == 0) {
+                    res.status = std::atoi(line.c_str() + 6);
+                    done = true;
+                } else {
+                    output += line;
+                    output += '\n';
+                }
+            }
+            monitor.check();
+        }
+        res.wall_time = monitor.elapsed();
+        res.killed = monitor.killed;
+        finish_result(res, job, limits, *prog.data, output);
+    }
+
+    // The server died; it is restarted for the next job
+    if(!done)
+        stop_server(server);
+    return res;
+}
+
+void SuiteRunner::run(const std::vector<SuiteJob>& jobs, const Callback& done)
+{
+    int nworker = std::min<std::size_t>(m_nworker, std::max<std::size_t>(jobs.size(), 1));
+    if(!m_cpus.empty())
+        nworker = std::min<int>(nworker, m_cpus.size());
+    JobQueue queue(jobs.size());
+    std::mutex done_lock;
+    // Writing to a fork server that has died must not kill the runner
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<std::thread> workers;
+    for(int w = 0; w < nworker; w++)
+    {
+        workers.push_back(std::thread([&, w]() {
+            // The children and the fork server inherit the affinity
+            int cpu = -1;
+            if(!m_cpus.empty())
+            {
+                if(pin_thread(m_cpus[w]))
+                {
+                    cpu = m_cpus[w];
+                } else {
+                    std::lock_guard<std::mutex> lock(done_lock);
+                    std::cerr << "# Cannot pin worker " << w << " to CPU " << m_cpus[w] << std::endl;
+                }
+            }
+            ProgressFile prog;
+            ForkServer server;
+            std::size_t j;
+            while(queue.pop(j))
+            {
+                SuiteResult res = m_server ?
+                    execute_server(jobs[j], m_program, m_limits, prog, server) :
+                    execute_process(jobs[j], m_program, m_wrapper, m_limits, prog);
+                res.cpu = cpu;
+                std::lock_guard<std::mutex> lock(done_lock);
+                done(jobs[j], res);
+            }
+            stop_server(server);
+        }));
+    }
+    for(auto& t: workers)
+        t.join();
+}
@@ -0,0 +1,93 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_SUITE_H
+#define CUTEST_SUITE_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "json.hpp"
+
+// A unit of work: one problem directory containing a compiled run.out,
+// optionally restricted to a single solver
+struct SuiteJob
+{
+    std::string path;        // Problem directory
+    std::string solver;      // Solver passed to run.out, empty for all solvers
+    nlohmann::json config;   // Solver parameters (see param.h), null for defaults
+    std::string key;         // Result cache key, empty if not cached
+    double      cost;        // Estimated run time in seconds, see history.h
+
+    SuiteJob() : cost(0.0) {}
+};
+
+// Arguments of run.out for a job, after the program name
+std::vector<std::string> job_args(const SuiteJob& job);
+
+// Outcome of running one job
+struct SuiteResult
+{
+    int         status;      // Exit code of the program, or -signal if killed
+    int         killed;      // 0-not killed, 3-wall-clock limit, 4-memory limit
+    double      wall_time;   // Wall-clock time of the process, in seconds
+    int         cpu;         // CPU the worker was pinned to, -1 if not pinned
+    std::vector<nlohmann::json> records;  // JSON records printed by the program
+};
+
+// Resource limits enforced on each job, 0 meaning no limit
+struct SuiteLimits
+{
+    double      timeout;     // Wall-clock time limit, in seconds
+    double      max_rss;     // Resident set size limit, in MB
+};
+
+// Run jobs in parallel on a fixed number of worker threads, each of which
+// executes one child process at a time
+//
+// Workers take the jobs from one shared queue, in the order given, so that
+// all workers stay busy until the very end and jobs sorted by decreasing
+// cost are started longest first
+class SuiteRunner
+{
+public:
+    using Callback = std::function<void(const SuiteJob&, const SuiteResult&)>;
+    using Wrapper = std::function<std::vector<std::string>(const SuiteJob&)>;
+
+    // program is executed from within the problem directory
+    SuiteRunner(int nworker, const std::string& program = "./run.out");
+
+    // Set the per-job limits. A job exceeding them is killed, and the solve
+    // that was running is reported with flag 3 or 4 and the iteration and
+    // evaluation counts it had reached
+    void set_limits(const SuiteLimits& limits) { m_limits = limits; }
+
+    // Run each job through a fork server instead of starting the program
+    // anew. Each worker starts "program --server" once and sends it the
+    // jobs, see driver.cpp; this saves the process startup per job
+    void set_server(bool server) { m_server = server; }
+
+    // Run the program of each job under another one, e.g. Valgrind: the
+    // command line wrapper(job) is put before the program and its arguments.
+    // Called from the worker threads. Not supported with the fork server
+    void set_wrapper(const Wrapper& wrapper) { m_wrapper = wrapper; }
+
+    // Pin worker i to the logical CPU cpus[i], see affinity.h. The number
+    // of workers is limited to the number of CPUs
+    void set_cpus(const std::vector<int>& cpus) { m_cpus = cpus; }
+
+    // Run all jobs. done is called once per job as soon as the job finishes,
+    // and calls are serialized so that the callback does not need locking
+    void run(const std::vector<SuiteJob>& jobs, const Callback& done);
+
+private:
+    int         m_nworker;
+    std::string m_program;
+    SuiteLimits m_limits;
+    bool        m_server;
+    Wrapper     m_wrapper;
+    std::vector<int> m_cpus;
+};
+
+
+#endif  // CUTEST_SUITE_H
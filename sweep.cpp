@@ -0,0 +1,58 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <fstream>
+#include <stdexcept>
+#include "sweep.h"
+#include "param.h"
+
+using json = nlohmann::json;
+
+std::vector<json> expand_grid(const json& grid, const json& base)
+{
+    if(!grid.is_object())
+        throw std::invalid_argument("parameter grid must be a JSON object");
+
+    std::vector<json> configs(1, base.is_object() ? base : json::object());
+    for(json::const_iterator it = grid.begin(); it != grid.end(); ++it)
+    {
+        const json values = it.value().is_array() ? it.value() : json::array({ it.value() });
+        if(values.empty())
+            throw std::invalid_argument("no values for parameter " + it.key());
+
+        std::vector<json> next;
+        next.reserve(configs.size() * values.size());
+        for(const json& conf: configs)
+        {
+            for(const json& value: values)
+            {
+                json c = conf;
+                c[it.key()] = value;
+                next.push_back(c);
+            }
+        }
+        configs.swap(next);
+    }
+
+    // Check names and types once for all configurations
+    for(const json& conf: configs)
+    {
+        SolverConfig check;
+        check.merge(conf);
+    }
+    return configs;
+}
+
+std::vector<json> expand_grid_file(const std::string& path, const json& base)
+{
+    std::ifstream in(path);
+    if(!in)
+        throw std::invalid_argument("cannot open parameter grid " + path);
+    json grid;
+    try {
+        grid = json::parse(in);
+    } catch (json::exception& e) {
+        throw std::invalid_argument(path + ": " + e.what());
+    }
+    return expand_grid(grid, base);
+}
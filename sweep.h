@@ -0,0 +1,26 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_SWEEP_H
+#define CUTEST_SWEEP_H
+
+#include <string>
+#include <vector>
+#include "json.hpp"
+
+// Expand a parameter grid into the list of solver configurations
+//
+// The grid is a JSON object mapping parameter names (see param.h) to either
+// a single value or an array of values, e.g.
+//   { "m": [3, 6, 10, 20], "epsilon": [1e-5, 1e-7], "max_linesearch": 20 }
+// and the result is the Cartesian product of the arrays, each configuration
+// starting from base. The order is deterministic: parameters are taken in
+// name order, with the last one varying fastest. Throws
+// std::invalid_argument if a configuration is not valid
+std::vector<nlohmann::json> expand_grid(const nlohmann::json& grid, const nlohmann::json& base);
+
+// Read a grid from a JSON file and expand it
+std::vector<nlohmann::json> expand_grid_file(const std::string& path, const nlohmann::json& base);
+
+
+#endif  // CUTEST_SWEEP_H
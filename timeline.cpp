@@ -0,0 +1,49 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include "timeline.h"
+
+// Size of the write buffer, so that small spans do not cost a system call
+static const std::size_t buffer_size = 1 << 20;
+
+TimelineWriter::TimelineWriter(const std::string& path, const std::string& name, double origin) :
+    m_file(NULL), m_origin(origin), m_first(true)
+{
+    m_file = std::fopen(path.c_str(), "w");
+    if(!m_file)
+        return;
+    std::setvbuf(m_file, NULL, _IOFBF, buffer_size);
+
+    // The name is a problem and solver name, which need no escaping
+    std::fprintf(m_file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    begin_event();
+    std::fprintf(m_file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+                 "\"args\":{\"name\":\"%s\"}}", name.c_str());
+}
+
+TimelineWriter::~TimelineWriter()
+{
+    if(!m_file)
+        return;
+    std::fprintf(m_file, "\n]}\n");
+    std::fclose(m_file);
+}
+
+void TimelineWriter::begin_event()
+{
+    if(!m_first)
+        std::fputs(",\n", m_file);
+    m_first = false;
+}
+
+void TimelineWriter::span(const char* name, double start, double end, const char* arg_name, long arg)
+{
+    if(!m_file)
+        return;
+    begin_event();
+    std::fprintf(m_file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f",
+                 name, 1e6 * (start - m_origin), 1e6 * (end - start));
+    if(arg_name)
+        std::fprintf(m_file, ",\"args\":{\"%s\":%ld}", arg_name, arg);
+    std::fputc('}', m_file);
+}
@@ -0,0 +1,44 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_TIMELINE_H
+#define CUTEST_TIMELINE_H
+
+#include <cstdio>
+#include <string>
+
+// Timeline of a solve in the trace event format of Chrome, which can be
+// opened in chrome://tracing or https://ui.perfetto.dev
+//
+// Each span is a complete ("X") event of a single thread, written as soon
+// as it ends through a buffered file. Times are given as monotonic
+// wall-clock seconds (e.g. WallCpuTime::now().wall) and stored in
+// microseconds relative to the origin passed to the constructor
+class TimelineWriter
+{
+private:
+    std::FILE* m_file;
+    double     m_origin;
+    bool       m_first;   // Whether no event has been written yet
+
+    void begin_event();
+
+public:
+    // Create the file path, with name as the process name in the viewer
+    TimelineWriter(const std::string& path, const std::string& name, double origin);
+    // Terminate the JSON document and close the file
+    ~TimelineWriter();
+
+    bool is_open() const { return m_file != NULL; }
+
+    // Span from start to end, with an optional integer argument shown as
+    // arg_name in the viewer (not written if arg_name is NULL)
+    void span(const char* name, double start, double end, const char* arg_name = NULL, long arg = 0);
+
+private:
+    TimelineWriter(const TimelineWriter&);
+    TimelineWriter& operator=(const TimelineWriter&);
+};
+
+
+#endif  // CUTEST_TIMELINE_H
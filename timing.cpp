@@ -0,0 +1,119 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <ctime>
+#include "timing.h"
+#include "param.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds_since(const Clock::time_point& start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Median of a sorted vector
+static double sorted_median(const std::vector<double>& x)
+{
+    const std::size_t n = x.size();
+    return (n % 2 == 1) ? x[n / 2] : 0.5 * (x[n / 2 - 1] + x[n / 2]);
+}
+
+// Summary statistics of the samples
+static void summarize(std::vector<double> x, RepeatTiming& res)
+{
+    std::sort(x.begin(), x.end());
+    const int n = x.size();
+    res.nrep = n;
+    res.min = x[0];
+    res.median = sorted_median(x);
+
+    std::vector<double> dev(n);
+    for(int i = 0; i < n; i++)
+        dev[i] = std::abs(x[i] - res.median);
+    std::sort(dev.begin(), dev.end());
+    res.mad = sorted_median(dev);
+
+    // Distribution-free 95% interval of the median (Le Boudec, Performance
+    // Evaluation of Computer and Communication Systems, 2010): the samples
+    // of 1-based ranks floor(n/2 - 0.98 sqrt(n)) and
+    // ceil(n/2 + 0.98 sqrt(n)) + 1, symmetric about the rank (n + 1)/2 of
+    // the median. As 0-based indices, the lower one loses 1 and the upper
+    // one is the ceil itself
+    const double half = 0.98 * std::sqrt(double(n));
+    const int lower = std::max(0, int(std::floor(0.5 * n - half)) - 1);
+    const int upper = std::min(n - 1, int(std::ceil(0.5 * n + half)));
+    res.ci_lower = x[lower];
+    res.ci_upper = x[upper];
+}
+
+WallCpuTime WallCpuTime::now()
+{
+    timespec wall, cpu;
+    clock_gettime(CLOCK_MONOTONIC, &wall);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu);
+    return WallCpuTime(wall.tv_sec + 1e-9 * wall.tv_nsec, cpu.tv_sec + 1e-9 * cpu.tv_nsec);
+}
+
+bool repeat_timing_enabled(const SolverConfig& config)
+{
+    return config.get("repeat_max", 0) > 0;
+}
+
+RepeatTiming time_repeated(const std::function<bool()>& solve, const SolverConfig& config)
+{
+    const int max_rep = config.get("repeat_max", 0);
+    const int min_rep = std::min(max_rep, config.get("repeat_min", 5));
+    const int warmup = std::max(1, config.get("repeat_warmup", 1));
+    const double rel_ci = config.get("repeat_rel_ci", 0.01);
+    const double batch_time = config.get("repeat_batch_time", 1e-3);
+    const double max_time = config.get("repeat_max_time", 10.0);
+
+    RepeatTiming res;
+    if(max_rep <= 0)
+        return res;
+
+    const Clock::time_point begin = Clock::now();
+    double last = 0.0;
+    for(int i = 0; i < warmup; i++)
+    {
+        const Clock::time_point start = Clock::now();
+        if(!solve())
+            return res;
+        last = seconds_since(start);
+        res.warmup++;
+    }
+
+    // Tiny solves are batched so that each timer read covers batch_time
+    res.batch = 1;
+    if(last < batch_time)
+        res.batch = (last > 0.0) ? int(std::min(1e6, std::ceil(batch_time / last))) : 1000;
+
+    std::vector<double> samples;
+    bool failed = false;
+    while(!failed && int(samples.size()) < max_rep)
+    {
+        const Clock::time_point start = Clock::now();
+        for(int b = 0; b < res.batch && !failed; b++)
+            failed = !solve();
+        // A batch cut short by a failure is not a sample
+        if(failed)
+            break;
+        samples.push_back(seconds_since(start) / res.batch);
+
+        if(int(samples.size()) < min_rep)
+            continue;
+        summarize(samples, res);
+        if(0.5 * (res.ci_upper - res.ci_lower) <= rel_ci * res.median)
+            break;
+        if(seconds_since(begin) >= max_time)
+            break;
+    }
+    if(!samples.empty())
+        summarize(samples, res);
+    return res;
+}
@@ -0,0 +1,73 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_TIMING_H
+#define CUTEST_TIMING_H
+
+#include <functional>
+
+class SolverConfig;
+
+// Wall-clock (CLOCK_MONOTONIC) and CPU (CLOCK_PROCESS_CPUTIME_ID) time in
+// seconds, either a point in time or a duration
+struct WallCpuTime
+{
+    double wall;
+    double cpu;
+
+    WallCpuTime() : wall(0.0), cpu(0.0) {}
+    WallCpuTime(double wall_, double cpu_) : wall(wall_), cpu(cpu_) {}
+
+    static WallCpuTime now();
+
+    WallCpuTime operator-(const WallCpuTime& other) const
+    {
+        return WallCpuTime(wall - other.wall, cpu - other.cpu);
+    }
+    WallCpuTime& operator+=(const WallCpuTime& other)
+    {
+        wall += other.wall;
+        cpu += other.cpu;
+        return *this;
+    }
+};
+
+// Summary of the repeated timing of a solve, all times in seconds
+//
+// Times are wall-clock (steady_clock), unlike solve_time, which is the CPU
+// time reported by CUTEst for the first solve. Each sample is the average
+// over a batch of consecutive solves
+struct RepeatTiming
+{
+    int    nrep;             // Number of samples, 0 if not measured
+    int    batch;            // Number of solves per sample
+    int    warmup;           // Number of solves discarded before sampling
+    double min;              // Smallest sample
+    double median;           // Median of the samples
+    double mad;              // Median absolute deviation from the median
+    double ci_lower;         // 95% confidence interval of the median,
+    double ci_upper;         // from order statistics
+
+    RepeatTiming() :
+        nrep(0), batch(0), warmup(0), min(0.0), median(0.0), mad(0.0),
+        ci_lower(0.0), ci_upper(0.0)
+    {}
+};
+
+// Whether repeated timing is requested, i.e. repeat_max > 0
+bool repeat_timing_enabled(const SolverConfig& config);
+
+// Time solve(), which must start again from the initial point each time and
+// return false if it failed
+//
+// After repeat_warmup solves (at least one, used to size the batches),
+// batches of solves lasting at least repeat_batch_time are timed until the
+// half-width of the confidence interval is within repeat_rel_ci of the
+// median, with at least repeat_min and at most repeat_max samples, or until
+// repeat_max_time seconds have been spent. See param.h for the defaults.
+// A failed solve stops the sampling, keeping the samples of the batches
+// completed before it
+RepeatTiming time_repeated(const std::function<bool()>& solve, const SolverConfig& config);
+
+
+#endif  // CUTEST_TIMING_H
@@ -0,0 +1,133 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <unistd.h>
+#include <fcntl.h>
+#include "trace.h"
+
+// Number of entries per block, and number of full blocks kept in memory
+// before the solver waits for the writer
+static const std::size_t block_size = 4096;
+static const std::size_t max_pending = 16;
+
+static double monotonic_time()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+static void write_all(int fd, const void* data, std::size_t size)
+{
+    const char* p = static_cast<const char*>(data);
+    while(size > 0)
+    {
+        const ssize_t n = write(fd, p, size);
+        if(n <= 0)
+            return;
+        p += n;
+        size -= n;
+    }
+}
+
+TraceWriter::TraceWriter(const std::string& path, const char* alg, const char* solver, const char* prob, int nvar) :
+    m_fd(-1), m_start(monotonic_time()), m_neval(0), m_stop(false)
+{
+    m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(m_fd < 0)
+        return;
+
+    TraceHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "CUTTRACE", 8);
+    header.version = 1;
+    header.entry_size = sizeof(TraceEntry);
+    header.nvar = nvar;
+    std::strncpy(header.prob, prob, 15);
+    std::strncpy(header.alg, alg, 15);
+    std::strncpy(header.solver, solver, 15);
+    write_all(m_fd, &header, sizeof(header));
+
+    m_block.reserve(block_size);
+    m_thread = std::thread(&TraceWriter::write_loop, this);
+}
+
+TraceWriter::~TraceWriter()
+{
+    if(m_fd < 0)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if(!m_block.empty())
+            m_pending.push_back(std::move(m_block));
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    m_thread.join();
+    close(m_fd);
+}
+
+void TraceWriter::push(const TraceEntry& entry)
+{
+    if(m_fd < 0)
+        return;
+    m_block.push_back(entry);
+    if(m_block.size() < block_size)
+        return;
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_cond.wait(lock, [this]() { return m_pending.size() < max_pending; });
+    m_pending.push_back(std::move(m_block));
+    lock.unlock();
+    m_cond.notify_all();
+    m_block = Block();
+    m_block.reserve(block_size);
+}
+
+void TraceWriter::write_loop()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    while(true)
+    {
+        m_cond.wait(lock, [this]() { return m_stop || !m_pending.empty(); });
+        if(m_pending.empty())
+            return;
+        Block block = std::move(m_pending.front());
+        m_pending.pop_front();
+        lock.unlock();
+        m_cond.notify_all();
+        write_all(m_fd, block.data(), block.size() * sizeof(TraceEntry));
+        lock.lock();
+    }
+}
+
+void TraceWriter::evaluation(double f, double gnorm)
+{
+    TraceEntry entry;
+    entry.kind = 1;
+    entry.index = ++m_neval;
+    entry.ntrial = -1;
+    entry.nactive = -1;
+    entry.time = monotonic_time() - m_start;
+    entry.f = f;
+    entry.gnorm = gnorm;
+    entry.step = std::numeric_limits<double>::quiet_NaN();
+    push(entry);
+}
+
+void TraceWriter::iteration(int iter, double f, double gnorm, double step, int ntrial, int nactive)
+{
+    TraceEntry entry;
+    entry.kind = 2;
+    entry.index = iter;
+    entry.ntrial = ntrial;
+    entry.nactive = nactive;
+    entry.time = monotonic_time() - m_start;
+    entry.f = f;
+    entry.gnorm = gnorm;
+    entry.step = step;
+    push(entry);
+}
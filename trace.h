@@ -0,0 +1,107 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#ifndef CUTEST_TRACE_H
+#define CUTEST_TRACE_H
+
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+// Binary trace of a solve, one entry per evaluation and per iteration
+//
+// The file starts with a TraceHeader, followed by TraceEntry records in
+// native byte order. Entries are appended in blocks by a background thread,
+// so the solver only copies 48 bytes per entry; if the disk cannot keep up,
+// the solver waits once a few blocks are pending, which bounds the memory
+// used. A trace cut short by a kill is still valid up to its last block.
+// Use trace_dump.out to convert a trace to CSV
+struct TraceHeader
+{
+    char     magic[8];       // "CUTTRACE"
+    uint32_t version;        // 1
+    uint32_t entry_size;     // sizeof(TraceEntry)
+    int32_t  nvar;           // Number of variables
+    int32_t  reserved;
+    char     prob[16];       // Problem name
+    char     alg[16];        // Algorithm, e.g. "L-BFGS-B"
+    char     solver[16];     // Solver, e.g. "Classic"
+};
+
+struct TraceEntry
+{
+    uint32_t kind;           // 1-evaluation, 2-iteration
+    uint32_t index;          // Evaluation or iteration number, from 1
+    int32_t  ntrial;         // Iteration: number of evaluations in the line search, -1 if unknown
+    int32_t  nactive;        // Iteration: number of variables at a bound, -1 if unconstrained
+    double   time;           // Seconds since the start of the trace
+    double   f;              // Objective function value
+    double   gnorm;          // Evaluation: 2-norm of the gradient; iteration: 2-norm of
+                             // the gradient (unconstrained) or infinity norm of the
+                             // projected gradient (box-constrained)
+    double   step;           // Iteration: step length of the line search, NaN if unknown
+};
+
+class TraceWriter
+{
+private:
+    using Block = std::vector<TraceEntry>;
+
+    int                     m_fd;
+    double                  m_start;
+    uint32_t                m_neval;
+    Block                   m_block;     // Block being filled by the solver
+    std::deque<Block>       m_pending;   // Full blocks waiting to be written
+    bool                    m_stop;
+    std::mutex              m_lock;
+    std::condition_variable m_cond;
+    std::thread             m_thread;
+
+    void push(const TraceEntry& entry);
+    void write_loop();
+
+public:
+    // Create the file path and write the header
+    TraceWriter(const std::string& path, const char* alg, const char* solver, const char* prob, int nvar);
+    // Write the remaining entries and close the file
+    ~TraceWriter();
+
+    bool is_open() const { return m_fd >= 0; }
+
+    void evaluation(double f, double gnorm);
+    void iteration(int iter, double f, double gnorm, double step, int ntrial, int nactive);
+
+private:
+    TraceWriter(const TraceWriter&);
+    TraceWriter& operator=(const TraceWriter&);
+};
+
+// Infinity norm of the projected gradient, as in L-BFGS-B, and the number of
+// variables at a bound. Infinite bounds are allowed
+template <typename Vector>
+double projected_grad_norm(const Vector& x, const Vector& grad, const Vector& lb, const Vector& ub, int& nactive)
+{
+    double norm = 0.0;
+    nactive = 0;
+    for(int i = 0; i < int(x.size()); i++)
+    {
+        double g = grad[i];
+        if(g < 0.0)
+            g = std::max(double(x[i] - ub[i]), g);
+        else
+            g = std::min(double(x[i] - lb[i]), g);
+        norm = std::max(norm, std::abs(g));
+        if(x[i] <= lb[i] || x[i] >= ub[i])
+            nactive++;
+    }
+    return norm;
+}
+
+
+#endif  // CUTEST_TRACE_H
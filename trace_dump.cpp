@@ -0,0 +1,43 @@
+// Copyright (C) 2023 Yixuan Qiu <yixuan.qiu@cos.name>
+// Under MIT license
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <limits>
+#include "trace.h"
+
+// Print a trace written by the "trace" option (see trace.h) as CSV
+int main(int argc, char* argv[])
+{
+    if(argc != 2)
+    {
+        std::cerr << "Usage: trace_dump.out TRACE_FILE" << std::endl;
+        return 1;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    TraceHeader header;
+    if(!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+       std::memcmp(header.magic, "CUTTRACE", 8) != 0 || header.version != 1 ||
+       header.entry_size != sizeof(TraceEntry))
+    {
+        std::cerr << argv[1] << ": not a trace file" << std::endl;
+        return 1;
+    }
+
+    header.prob[15] = header.alg[15] = header.solver[15] = '\0';
+    std::cout << "# " << header.prob << " " << header.alg << " " << header.solver
+              << " nvar=" << header.nvar << std::endl;
+    std::cout << "kind,index,ntrial,nactive,time,f,gnorm,step" << std::endl;
+    std::cout.precision(std::numeric_limits<double>::max_digits10);
+
+    TraceEntry e;
+    while(in.read(reinterpret_cast<char*>(&e), sizeof(e)))
+    {
+        std::cout << (e.kind == 1 ? "eval" : "iter") << "," << e.index << ","
+                  << e.ntrial << "," << e.nactive << "," << e.time << ","
+                  << e.f << "," << e.gnorm << "," << e.step << std::endl;
+    }
+    return 0;
+}
@@ -1,8 +1,9 @@
+#include <cstring>
 #include "interface.h"
 #include <LBFGS.h>
 using namespace LBFGSpp;
 
-void unconstr_lbfgs_stat(CUTEstStat& stat, bool verbose)
+void unconstr_lbfgs_stat(CUTEstStat& stat, const SolverConfig& config, bool verbose)
 {
     using Vector = Eigen::Matrix<doublereal, Eigen::Dynamic, 1>;
 
@@ -41,19 +42,22 @@ void unconstr_lbfgs_stat(CUTEstStat& stat, bool verbose)
         return;
     }
     if(verbose)
-        std::cout << "nvar = " << CUTEst_nvar << std::endl;
+        std::cerr << "nvar = " << CUTEst_nvar << std::endl;
 
     // Reserve memory for variables and bounds,
     // and call appropriate initialization routine for CUTEst
     Vector x(CUTEst_nvar);
     Vector lb(CUTEst_nvar);
     Vector ub(CUTEst_nvar);
-    // FORTRAN unit number for error output
-    integer iout = 6;
+    // FORTRAN unit number for error output, see FortranMessages
+    const FortranMessages messages("Classic");
+    integer iout = messages.unit();
     // FORTRAN unit internal input/output
     integer io_buffer = 11;
+    const double setup_start = WallCpuTime::now().wall;
     CUTEST_usetup(&status, &funit, &iout, &io_buffer,
                   &CUTEst_nvar, x.data(), lb.data(), ub.data());
+    const double setup_end = WallCpuTime::now().wall;
     if(status)
     {
         stat.flag = 2;
@@ -73,7 +77,7 @@ void unconstr_lbfgs_stat(CUTEstStat& stat, bool verbose)
         return;
     }
     if(verbose)
-        std::cout << "x0 = " <<  x.transpose().head(10) << " ... " <<  x.transpose().tail(10) << std::endl;
+        std::cerr << "x0 = " <<  x.transpose().head(10) << " ... " <<  x.transpose().tail(10) << std::endl;
 
     // Problem name
     char prob_name[16];
@@ -86,14 +90,24 @@ void unconstr_lbfgs_stat(CUTEstStat& stat, bool verbose)
         CUTEST_uterminate(&status);
         return;
     }
+    progress_start("L-BFGS", "Classic", prob_name, CUTEst_nvar);
 
     // Algorithm parameters
-    const integer param_m = 6;
+    const integer param_m = config.get("m", 6);
     // For very large problems, restrict to 1000 iterations
-    const integer param_maxit = (CUTEst_nvar < 50000) ? 10000 : 1000;
-    const doublereal param_eps = 1e-5;
+    const integer param_maxit = (CUTEst_nvar < config.get("large_nvar", 50000)) ?
+        config.get("max_iterations", 10000) : config.get("large_max_iterations", 1000);
+    const doublereal param_eps = config.get("epsilon", 1e-5);
     // Machine precision
     const doublereal param_xtol = std::numeric_limits<doublereal>::epsilon();
+    // Line search parameters, reset to the defaults of BLOCK DATA LB2
+    // unless given, since the common block outlives a solve in driver.out
+    // Messages of the solver go to the same unit as those of CUTEst
+    lb3_.mp = iout;
+    lb3_.lp = iout;
+    lb3_.gtol = config.get("gtol", 0.9);
+    lb3_.stpmin = config.get("stpmin", 1e-20);
+    lb3_.stpmax = config.get("stpmax", 1e20);
     // Do not provide H0
     const integer diagco = 0;
     // Reuse the memory of lb
@@ -111,53 +125,129 @@ void unconstr_lbfgs_stat(CUTEstStat& stat, bool verbose)
 
     // Working space and flags
     Vector work(CUTEst_nvar * (2 * param_m + 1) + 2 * param_m);
-    integer iflag = 0;
+    integer iflag;
 
-    // Optimization process
-    integer i;
-    for (i = 0; i < param_maxit; i++)
-    {
-        // Compute objective function value and gradient
-        fx = fun(x, grad);
-        // Call L-BFGS routine
-        lbfgs_(&CUTEst_nvar, &param_m, x.data(), &fx, grad.data(),
-            &diagco, diag.data(), iprint, &param_eps, &param_xtol,
-            work.data(), &iflag);
-        // If iflag = 1, then continue iteration
-        if (iflag == 1)
+    // Trace of the solve, if requested
+    std::unique_ptr<TraceWriter> trace = open_trace(config, "L-BFGS", "Classic", prob_name, CUTEst_nvar);
+    fun.set_trace(trace.get());
+    // Timeline of the solve, if requested
+    std::unique_ptr<TimelineWriter> timeline = open_timeline(config, "L-BFGS", "Classic", prob_name, setup_start);
+    if(timeline)
+        timeline->span("setup", setup_start, setup_end);
+    fun.set_timeline(timeline.get());
+    TimelineWriter* steps = timeline.get();
+    bool tracing = bool(trace);
+
+    // Optimization process, starting from x
+    // Returns the loop counter, with iflag < 0 if some error occurs
+    auto solve = [&]() {
+        iflag = 0;
+        integer i;
+        // lbfgs_ returns once per evaluation, but at the start of every
+        // iteration after the first it updates one of the scalars rho,
+        // stored in work[n, n + m), so the previous evaluation was the
+        // accepted point of an iteration
+        Vector rho = work.segment(CUTEst_nvar, param_m);
+        int niter = 0;
+        for (i = 0; i < param_maxit; i++)
         {
-            continue;
-        } // If iflag = 0, then the solver finishes
-        else if (iflag == 0) {
+            // Compute objective function value and gradient
+            fx = fun(x, grad);
+            // Call L-BFGS routine
+            const double step_start = steps ? WallCpuTime::now().wall : 0.0;
+            lbfgs_(&CUTEst_nvar, &param_m, x.data(), &fx, grad.data(),
+                &diagco, diag.data(), iprint, &param_eps, &param_xtol,
+                work.data(), &iflag);
+            if (steps)
+                steps->span("lbfgs", step_start, WallCpuTime::now().wall, "iflag", iflag);
+            if (tracing && iflag >= 0)
+            {
+                const doublereal* new_rho = work.data() + CUTEst_nvar;
+                if (iflag == 0 || std::memcmp(new_rho, rho.data(), param_m * sizeof(doublereal)) != 0)
+                {
+                    fun.trace_iteration(++niter);
+                    std::memcpy(rho.data(), new_rho, param_m * sizeof(doublereal));
+                }
+            }
+            // If iflag = 1, then continue iteration
+            if (iflag == 1)
+            {
+                progress_iter(i + 1);
+                continue;
+            }
+            // If iflag = 0, then the solver finishes, and if iflag < 0,
+            // then some error occurs
             break;
-        } // If iflag < 0, then some error occurs
-        else
-        {
-            // Errors
-            stat.prob = std::string(prob_name);
-            stat.nvar = CUTEst_nvar;
-            stat.flag = 1;
-            stat.msg = std::string("L-BFGS solver failed with code ") +
-                std::to_string(iflag);
-            CUTEST_uterminate(&status);
-            return;
         }
+        return i;
+    };
+    const Vector x0 = x;
+    // Hardware counters, if requested
+    PerfCounters solve_perf(config.get("perf", 0) > 0), oracle_perf(config.get("perf", 0) > 1);
+    if(oracle_perf.available())
+        fun.set_oracle_counters(&oracle_perf);
+    MemoryMeter memory;
+    // Sampling profile, if requested
+    Profiler profiler(config.get("profile", 0));
+    memory.start();
+    profiler.start();
+    solve_perf.start();
+    const WallCpuTime start = WallCpuTime::now();
+    const integer i = solve();
+    const WallCpuTime loop_time = WallCpuTime::now() - start;
+    solve_perf.stop();
+    profiler.stop();
+    const MemoryUsage memory_usage = memory.stop();
+    fun.set_oracle_counters(NULL);
+    fun.set_trace(NULL);
+    tracing = false;
+    fun.set_timeline(NULL);
+    steps = NULL;
+    if(timeline)
+        timeline->span("solve", start.wall, start.wall + loop_time.wall);
+    if (iflag < 0)
+    {
+        // Errors
+        stat.prob = std::string(prob_name);
+        stat.nvar = CUTEst_nvar;
+        stat.flag = 1;
+        stat.msg = std::string("L-BFGS solver failed with code ") +
+            std::to_string(iflag);
+        CUTEST_uterminate(&status);
+        return;
     }
 
     doublereal calls[4], time[2];
     CUTEST_ureport(&status, calls, time);
 
     if(verbose)
-        std::cout << "x = " << x.transpose().head(5) << " ... " << x.transpose().tail(5) << std::endl << std::endl;
+        std::cerr << "x = " << x.transpose().head(5) << " ... " << x.transpose().tail(5) << std::endl << std::endl;
 
     stat.prob = std::string(prob_name);
     stat.nvar = CUTEst_nvar;
     stat.niter = std::min(i + 1, param_maxit);
     stat.nfun = calls[0];
+    stat.ngrad = calls[1];
+    stat.nhess = calls[2];
+    stat.nhprod = calls[3];
     stat.objval = fx;
     stat.proj_grad = grad.norm();
     stat.setup_time = time[0];
     stat.solve_time = time[1];
+    stat.oracle_time = fun.oracle_time();
+    stat.solver_time = loop_time - stat.oracle_time;
+    stat.perf = perf_to_json(solve_perf, oracle_perf);
+    stat.memory = memory_usage;
+    stat.profile = profiler.write_folded("profile_Classic.folded");
+    // diag reuses the memory of lb
+    stat.workspace = work.size() * sizeof(doublereal);
+
+    // Repeated timing, after the counters of CUTEst have been read
+    if(repeat_timing_enabled(config))
+        stat.timing = time_repeated([&]() { x = x0; solve(); return true; }, config);
 
+    const double teardown_start = WallCpuTime::now().wall;
     CUTEST_uterminate(&status);
+    if(timeline)
+        timeline->span("teardown", teardown_start, WallCpuTime::now().wall);
 }
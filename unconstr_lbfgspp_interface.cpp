@@ -2,7 +2,7 @@
 #include <LBFGS.h>
 using namespace LBFGSpp;
 
-void unconstr_lbfgspp_stat(CUTEstStat& stat, bool verbose)
+void unconstr_lbfgspp_stat(CUTEstStat& stat, const SolverConfig& config, bool verbose)
 {
     using Vector = Eigen::Matrix<doublereal, Eigen::Dynamic, 1>;
 
@@ -41,19 +41,22 @@ void unconstr_lbfgspp_stat(CUTEstStat& stat, bool verbose)
         return;
     }
     if(verbose)
-        std::cout << "nvar = " << CUTEst_nvar << std::endl;
+        std::cerr << "nvar = " << CUTEst_nvar << std::endl;
 
     // Reserve memory for variables and bounds,
     // and call appropriate initialization routine for CUTEst
     Vector x(CUTEst_nvar);
     Vector lb(CUTEst_nvar);
     Vector ub(CUTEst_nvar);
-    // FORTRAN unit number for error output
-    integer iout = 6;
+    // FORTRAN unit number for error output, see FortranMessages
+    const FortranMessages messages("LBFGS++");
+    integer iout = messages.unit();
     // FORTRAN unit internal input/output
     integer io_buffer = 11;
+    const double setup_start = WallCpuTime::now().wall;
     CUTEST_usetup(&status, &funit, &iout, &io_buffer,
                   &CUTEst_nvar, x.data(), lb.data(), ub.data());
+    const double setup_end = WallCpuTime::now().wall;
     if(status)
     {
         stat.flag = 2;
@@ -73,7 +76,7 @@ void unconstr_lbfgspp_stat(CUTEstStat& stat, bool verbose)
         return;
     }
     if(verbose)
-        std::cout << "x0 = " <<  x.transpose().head(10) << " ... " <<  x.transpose().tail(10) << std::endl;
+        std::cerr << "x0 = " <<  x.transpose().head(10) << " ... " <<  x.transpose().tail(10) << std::endl;
 
     // Problem name
     char prob_name[16];
@@ -86,28 +89,74 @@ void unconstr_lbfgspp_stat(CUTEstStat& stat, bool verbose)
         CUTEST_uterminate(&status);
         return;
     }
+    progress_start("L-BFGS", "LBFGS++", prob_name, CUTEst_nvar);
 
     // Set up LBFGS++ parameters
     LBFGSParam<doublereal> param;
-    param.m = 6;
+    param.m = config.get("m", 6);
     // For very large problems, restrict to 1000 iterations
-    param.max_iterations = (CUTEst_nvar < 50000) ? 10000 : 1000;
-    param.epsilon = 1e-5;
-    param.epsilon_rel = 1e-5;
-    param.past = 0;
-    param.delta = 0.0;
-    param.max_linesearch = 100;
+    param.max_iterations = (CUTEst_nvar < config.get("large_nvar", 50000)) ?
+        config.get("max_iterations", 10000) : config.get("large_max_iterations", 1000);
+    param.epsilon = config.get("epsilon", 1e-5);
+    param.epsilon_rel = config.get("epsilon_rel", 1e-5);
+    param.past = config.get("past", 0);
+    param.delta = config.get("delta", 0.0);
+    param.max_linesearch = config.get("max_linesearch", 100);
+    if(config.has("gtol"))
+        param.wolfe = config.get("gtol", 0.9);
+    if(config.has("stpmin"))
+        param.min_step = config.get("stpmin", 1e-20);
+    if(config.has("stpmax"))
+        param.max_step = config.get("stpmax", 1e20);
 
     // Objective function
     CUTEstProblem fun(CUTEst_nvar);
     doublereal fx;
 
     // Solver
-    LBFGSSolver<doublereal> solver(param);
+    LBFGSSolver<doublereal, ObservedLineSearch<LineSearchNocedalWright>::type> solver(param);
+    const Vector x0 = x;
+    // Trace of the solve, if requested
+    std::unique_ptr<TraceWriter> trace = open_trace(config, "L-BFGS", "LBFGS++", prob_name, CUTEst_nvar);
+    fun.set_trace(trace.get());
+    // Timeline of the solve, if requested
+    std::unique_ptr<TimelineWriter> timeline = open_timeline(config, "L-BFGS", "LBFGS++", prob_name, setup_start);
+    if(timeline)
+        timeline->span("setup", setup_start, setup_end);
+    fun.set_timeline(timeline.get());
+
+    // Hardware counters, if requested
+    PerfCounters solve_perf(config.get("perf", 0) > 0), oracle_perf(config.get("perf", 0) > 1);
+    if(oracle_perf.available())
+        fun.set_oracle_counters(&oracle_perf);
     int niter;
+    WallCpuTime loop_time;
+    MemoryMeter memory;
+    MemoryUsage memory_usage;
+    // Sampling profile, if requested
+    Profiler profiler(config.get("profile", 0));
+    // Heap allocations, in the ALLOC_COUNT build
+    AllocStats alloc_stats;
     try {
+        memory.start();
+        profiler.start();
+        solve_perf.start();
+        const WallCpuTime start = WallCpuTime::now();
+        if(alloc_count_available())
+            fun.set_alloc_counting(&alloc_stats);
         niter = solver.minimize(fun, x, fx);
+        fun.set_alloc_counting(NULL);
+        loop_time = WallCpuTime::now() - start;
+        solve_perf.stop();
+        profiler.stop();
+        memory_usage = memory.stop();
+        fun.set_oracle_counters(NULL);
+        fun.set_trace(NULL);
+        fun.set_timeline(NULL);
+        if(timeline)
+            timeline->span("solve", start.wall, start.wall + loop_time.wall);
     } catch (std::exception& e) {
+        fun.set_alloc_counting(NULL);
         stat.prob = std::string(prob_name);
         stat.nvar = CUTEst_nvar;
         stat.flag = 1;
@@ -120,16 +169,50 @@ void unconstr_lbfgspp_stat(CUTEstStat& stat, bool verbose)
     CUTEST_ureport(&status, calls, time);
 
     if(verbose)
-        std::cout << "x = " << x.transpose().head(5) << " ... " << x.transpose().tail(5) << std::endl << std::endl;
+        std::cerr << "x = " << x.transpose().head(5) << " ... " << x.transpose().tail(5) << std::endl << std::endl;
 
     stat.prob = std::string(prob_name);
     stat.nvar = CUTEst_nvar;
     stat.niter = niter;
     stat.nfun = calls[0];
+    stat.ngrad = calls[1];
+    stat.nhess = calls[2];
+    stat.nhprod = calls[3];
     stat.objval = fx;
     stat.proj_grad = solver.final_grad_norm();
     stat.setup_time = time[0];
     stat.solve_time = time[1];
+    stat.oracle_time = fun.oracle_time();
+    stat.solver_time = loop_time - stat.oracle_time;
+    stat.perf = perf_to_json(solve_perf, oracle_perf);
+    stat.memory = memory_usage;
+    stat.profile = profiler.write_folded("profile_LBFGS++.folded");
+    stat.alloc = alloc_to_json(alloc_stats);
+    // LBFGS++ allocates internally, so this is the persistent storage of
+    // LBFGSSolver: the correction pairs, ys and alpha of BFGSMat, the past
+    // objective values and the vectors xp, grad, gradp and drt
+    stat.workspace = sizeof(doublereal) *
+        (2L * param.m * CUTEst_nvar + 2 * param.m + param.past + 4L * CUTEst_nvar);
+
+    // Repeated timing, after the counters of CUTEst have been read. A solve
+    // that throws ends the sampling, keeping the samples taken before it
+    if(repeat_timing_enabled(config))
+    {
+        stat.timing = time_repeated([&]() {
+            x = x0;
+            try {
+                solver.minimize(fun, x, fx);
+            } catch (std::exception& e) {
+                if(verbose)
+                    std::cerr << "repeated timing stopped: " << e.what() << std::endl;
+                return false;
+            }
+            return true;
+        }, config);
+    }
 
+    const double teardown_start = WallCpuTime::now().wall;
     CUTEST_uterminate(&status);
+    if(timeline)
+        timeline->span("teardown", teardown_start, WallCpuTime::now().wall);
 }